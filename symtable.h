@@ -2,12 +2,30 @@
 #include <stddef.h>
 #ifndef SYMTABLE_INCLUDED
 #define SYMTABLE_INCLUDED
-/* A SymTable_T is a collection of items represented by key-value pairs in bindings. It can be implemented using a linked list or hash table. */
+/* A SymTable_T is a collection of items represented by key-value pairs in bindings. It can be implemented using a linked list or hash table.
+ Only symtableconcurrent.c and symtablesharded.c may be used by several threads at once; they allow every function except SymTable_free to be called concurrently on the same SymTable_T, provided the pfApply of SymTable_map does not modify it. */
 typedef struct SymTable *SymTable_T;
 /* SymTable_new is a function that takes no arguments and 
 returns a new SymTable with no bindings. 
 If there is insufficient memory, it returns NULL. */
 SymTable_T SymTable_new(void);
+/* A SymTable_HashFunction is a function that takes two arguments, a constant char pointer pcKey and a size_t uSeed,
+ and returns a hash code for pcKey. Different seeds should give unrelated hash codes for the same key. */
+typedef size_t (*SymTable_HashFunction)(const char *pcKey, size_t uSeed);
+/* SymTable_newWithHash is a function that takes two arguments, a SymTable_HashFunction pfHash and a size_t uSeed,
+ and returns a new SymTable with no bindings whose keys are hashed by pfHash with seed uSeed.
+ Unless pfHash is SymTable_hashPolynomial, buckets are chosen from the low bits of the hash code, so pfHash must mix every byte of pcKey into them.
+ If there is insufficient memory, it returns NULL. Provided by symtablelist.c and symtablehash.c. */
+SymTable_T SymTable_newWithHash(SymTable_HashFunction pfHash, size_t uSeed);
+/* SymTable_hashPolynomial is the byte-at-a-time hash function from the assignment specification, with uSeed as the starting value.
+ SymTable_new uses it with a seed of 0. Its collisions are easy to find, so it should not be given keys from untrusted sources. */
+size_t SymTable_hashPolynomial(const char *pcKey, size_t uSeed);
+/* SymTable_hashWord is a SymTable_HashFunction in the style of xxHash64 that consumes pcKey eight bytes at a time.
+ It is much faster than SymTable_hashPolynomial on long keys, and with a seed from SymTable_randomSeed its collisions cannot be predicted. */
+size_t SymTable_hashWord(const char *pcKey, size_t uSeed);
+/* SymTable_randomSeed is a function that takes no arguments and returns a seed for a SymTable_HashFunction.
+ Each call returns a different, unpredictable seed, so each table can have its own. */
+size_t SymTable_randomSeed(void);
 /* SymTable_free is a function that takes one argument, 
 a SymTable_T type oSymTable, and frees all memory occupied by oSymTable. */
 void SymTable_free(SymTable_T oSymTable);
@@ -33,8 +51,123 @@ void *SymTable_get(SymTable_T oSymTable, const char *pcKey);
 a constant char pointer pcKey. It removes the binding with key pcKey from oSymTable and returns the binding's value.
  Otherwise, it returns NULL without changing oSymTable. */
 void *SymTable_remove(SymTable_T oSymTable, const char *pcKey);
+/* A SymTable_Key holds the hash code and length of a key, as computed by SymTable_hashKey for one SymTable.
+ Its fields are private to the SymTable implementation. */
+typedef struct SymTable_Key
+{
+  size_t hash;
+  size_t length;
+} SymTable_Key;
+/* SymTable_hashKey is a function that takes two arguments, a SymTable_T type oSymTable and a constant char pointer pcKey,
+ and returns the SymTable_Key of pcKey in oSymTable. Computing it once lets callers that look up the same key repeatedly skip hashing it.
+ The result is only valid for oSymTable and for tables created with the same hash function and seed. Provided by symtablelist.c and symtablehash.c. */
+SymTable_Key SymTable_hashKey(SymTable_T oSymTable, const char *pcKey);
+/* SymTable_putHashed, SymTable_getHashed, and SymTable_removeHashed behave as SymTable_put, SymTable_get, and SymTable_remove,
+ but take oKey, which must be SymTable_hashKey(oSymTable, pcKey), instead of hashing pcKey. Provided by symtablelist.c and symtablehash.c. */
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey, SymTable_Key oKey, const void *pvValue);
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey, SymTable_Key oKey);
+void *SymTable_removeHashed(SymTable_T oSymTable, const char *pcKey, SymTable_Key oKey);
+/* A SymTablePool_T is a pool of interned keys that several tables can share, so that a key bound in many of them is stored once.
+ symtablepool.h declares the functions that manage it. */
+typedef struct SymTablePool *SymTablePool_T;
+/* SymTable_newWithPool is a function that takes one argument, a SymTablePool_T type oPool, and returns a new SymTable with no bindings
+ whose keys are interned in oPool instead of copied. Looking up a string that SymTablePool_intern returned compares it by address,
+ and SymTablePool_keyOf gives its SymTable_Key for the hashed functions without hashing it again. oPool must outlive the SymTable.
+ If there is insufficient memory, it returns NULL. Provided by symtablehash.c. */
+SymTable_T SymTable_newWithPool(SymTablePool_T oPool);
+/* SymTable_newScoped is a function that takes no arguments and returns a new SymTable with no bindings whose bindings belong to nested scopes,
+ as the declarations of a program do. Outside every scope, it behaves as SymTable_new. If there is insufficient memory, it returns NULL. Provided by symtablehash.c. */
+SymTable_T SymTable_newScoped(void);
+/* SymTable_clone is a function that takes one argument, a SymTable_T type oSymTable, and returns a new SymTable with the same bindings,
+ in time proportional to the number of buckets of oSymTable rather than its bindings. The two share their chains of bindings, and whichever first
+ changes a chain copies it, so neither sees the other's changes. Until then, SymTable_replace and SymTable_remove may need memory for the copy;
+ if there is none, they return NULL and leave the binding as it was. A chain is freed as soon as no table reaches it,
+ and a table whose clones have all been freed changes its chains in place again.
+ oSymTable must not have been created by SymTable_newWithPool or SymTable_newScoped. A table and its clones allocate from one arena, so between them
+ they may be used by only one thread at a time. The first expansion of a table that still shares chains copies all of them at once, in time proportional
+ to its bindings, instead of spreading the work over later calls as other expansions do. Copying a shared chain checks every other table cloned from the
+ same original, so changing a shared chain, and freeing a table with clones, take time that also grows with the number of such tables alive.
+ If there is insufficient memory, it returns NULL. Provided by symtablehash.c. */
+SymTable_T SymTable_clone(SymTable_T oSymTable);
+/* SymTable_save is a function that takes three arguments, a SymTable_T type oSymTable, a constant char pointer pcFilename,
+ and a function *pfValueSize that returns the number of bytes of a value. It writes to the file pcFilename an image of oSymTable
+ that SymTable_loadMapped can reopen: an open-addressed index of the bindings' hashes with the offsets of their keys and values,
+ and then each key followed by (*pfValueSize)(pvValue) bytes of its value if the value is not NULL, each starting at a multiple of 16 bytes. The image holds no pointers,
+ but it can be reopened only on a machine with the same size_t and byte order. The image is written to a new file in the same directory,
+ which replaces pcFilename only once it is complete and synced to disk, so a SymTable loaded from the old pcFilename keeps its bindings.
+ It returns 1, or 0 if the file cannot be written or there is insufficient memory, in which case pcFilename is left as it was. Provided by symtablehash.c. */
+int SymTable_save(SymTable_T oSymTable, const char *pcFilename, size_t (*pfValueSize)(const void *pvValue));
+/* SymTable_loadMapped is a function that takes one argument, a constant char pointer pcFilename naming a file written by SymTable_save,
+ and returns a new SymTable with the bindings saved in it. The file is mapped into memory rather than read: loading reads only the index,
+ to check that every key and value it gives lies within the file, and the keys and values are paged in as they are looked up. Keys are hashed with SymTable_hashWord and the seed stored in the image.
+ The SymTable is read-only: SymTable_put, SymTable_replace, SymTable_remove, and SymTable_clone must not be called on it, and each value it returns
+ points to the saved bytes, which must not be modified. The file must not change while the SymTable exists. If the file cannot be mapped,
+ is not an image that this machine can read, or there is insufficient memory, it returns NULL. Provided by symtablehash.c. */
+SymTable_T SymTable_loadMapped(const char *pcFilename);
+/* SymTable_freeze is a function that takes one argument, a SymTable_T type oSymTable not loaded by SymTable_loadMapped, and rebuilds it
+ around a minimal perfect hash of its keys: one slot per binding, and a pilot for every three or so keys that sends each key to its own slot,
+ so that a lookup compares just one key. If the table's hash function gives keys equal hashes, keys are then hashed with SymTable_hashWord
+ and a new seed instead, so a SymTable_Key computed before freezing must not be used after it. A scoped table keeps only its innermost bindings.
+ The SymTable is read-only afterwards: SymTable_put, SymTable_replace, SymTable_remove, SymTable_clone, and SymTable_enterScope must not be called on it.
+ Freezing a frozen table does nothing.
+ It returns 1, or 0, leaving oSymTable unchanged, if there is insufficient memory, the keys with their nul characters fill 4 GB or more,
+ or no perfect hash is found. Provided by symtablehash.c. */
+int SymTable_freeze(SymTable_T oSymTable);
+/* SymTable_enterScope is a function that takes one argument, a SymTable_T type oSymTable created by SymTable_newScoped, and begins a new innermost scope.
+ Within it, SymTable_put binds a key that is bound only in enclosing scopes, hiding those bindings, but still returns 0 for a key already bound in the scope itself.
+ SymTable_get, SymTable_replace, SymTable_map, SymTable_getLength, and the other functions see only the innermost binding of each key,
+ and SymTable_remove removes it, which reveals the binding it hid. Provided by symtablehash.c. */
+void SymTable_enterScope(SymTable_T oSymTable);
+/* SymTable_exitScope is a function that takes one argument, a SymTable_T type oSymTable created by SymTable_newScoped, inside at least one scope.
+ It removes every binding put in the innermost scope, revealing the bindings they hid, and ends the scope, in time proportional to the scope's bindings.
+ The bindings' values are not freed. Provided by symtablehash.c. */
+void SymTable_exitScope(SymTable_T oSymTable);
+/* SymTable_snapshot is a function that takes one argument, a SymTable_T type oSymTable, and returns a new SymTable with the same bindings, in constant time.
+ The two share their storage, and a later change to either one copies only the part it changes, so neither sees the other's changes. Each is freed separately,
+ in either order. Different threads may use oSymTable and its snapshots at once, though each table by only one thread at a time.
+ If there is insufficient memory, it returns NULL. Provided by symtablehamt.c. */
+SymTable_T SymTable_snapshot(SymTable_T oSymTable);
+/* SymTable_getMany is a function that takes four arguments, a SymTable_T type oSymTable, an array ppcKeys of uCount constant char pointers,
+ a size_t uCount, and an array ppvValues of uCount pointers. It sets ppvValues[i] to SymTable_get(oSymTable, ppcKeys[i]) for each i.
+ Looking keys up together lets their memory accesses overlap, which is faster than calling SymTable_get in a loop. Provided by symtablehash.c. */
+void SymTable_getMany(SymTable_T oSymTable, const char *const ppcKeys[], size_t uCount, void *ppvValues[]);
+/* SymTable_containsMany is like SymTable_getMany, but sets piFound[i] to SymTable_contains(oSymTable, ppcKeys[i]) for each i. Provided by symtablehash.c. */
+void SymTable_containsMany(SymTable_T oSymTable, const char *const ppcKeys[], size_t uCount, int piFound[]);
 /* SymTable_map is a function with three arguments, a SymTable_T type oSymTable,
  a function *pfApply with one constant char pointer argument type and two constant char pointer argument types (pcKey, pvValue, and pvExtra),
-and a constant pointer pvExtra. The function applies the *pfApply function to each binding in oSymTable and passes pvExtra as an extra arguement. */
+and a constant pointer pvExtra. The function applies the *pfApply function to each binding in oSymTable and passes pvExtra as an extra arguement.
+ symtableart.c and symtableordered.c visit bindings in ascending key order. */
 void SymTable_map(SymTable_T oSymTable, void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra), const void *pvExtra);
+/* A SymTable_Iterator marks a position among the bindings of a SymTable, for visiting them one at a time without a callback.
+ Its fields are private to the SymTable implementation. */
+typedef struct SymTable_Iterator
+{
+  void *node;
+  size_t bucket;
+  void *table;
+} SymTable_Iterator;
+/* SymTable_begin is a function that takes two arguments, a SymTable_T type oSymTable and a SymTable_Iterator pointer poIterator.
+ It positions *poIterator at the first binding of oSymTable and returns 1, or returns 0 if oSymTable is empty. Bindings are visited in no particular order.
+ Until the iteration ends, oSymTable may be read and its values replaced, but no binding may be put or removed. Provided by symtablelist.c and symtablehash.c. */
+int SymTable_begin(SymTable_T oSymTable, SymTable_Iterator *poIterator);
+/* SymTable_next is a function that takes two arguments, a SymTable_T type oSymTable and a SymTable_Iterator pointer poIterator positioned by SymTable_begin.
+ It moves *poIterator to the next binding of oSymTable and returns 1, or returns 0 if every binding has been visited. An iteration may stop at any time. Provided by symtablelist.c and symtablehash.c. */
+int SymTable_next(SymTable_T oSymTable, SymTable_Iterator *poIterator);
+/* SymTable_key and SymTable_value are functions that take one argument, a SymTable_Iterator pointer poIterator positioned at a binding,
+ and return the key and the value of that binding. Provided by symtablelist.c and symtablehash.c. */
+const char *SymTable_key(const SymTable_Iterator *poIterator);
+void *SymTable_value(const SymTable_Iterator *poIterator);
+/* SymTable_mapRange is a function that takes five arguments, a SymTable_T type oSymTable, constant char pointers pcLow and pcHigh,
+ a function *pfApply as for SymTable_map, and a constant pointer pvExtra. It applies *pfApply to each binding of oSymTable whose key is at least pcLow
+ and less than pcHigh, in ascending strcmp order, passing pvExtra. A NULL pcLow or pcHigh leaves that end of the range open. Provided by symtableordered.c,
+ whose SymTable_map also visits bindings in ascending order. */
+void SymTable_mapRange(SymTable_T oSymTable, const char *pcLow, const char *pcHigh, void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra), const void *pvExtra);
+/* SymTable_mapPrefix is like SymTable_mapRange, but applies *pfApply to each binding of oSymTable whose key begins with pcPrefix. Provided by symtableordered.c. */
+void SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix, void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra), const void *pvExtra);
+/* SymTable_mapParallel is a function that takes six arguments, a SymTable_T type oSymTable, a size_t uThreads, a function *pfApply as for SymTable_map,
+ an array ppvExtras of uThreads pointers, a function *pfReduce, and a pointer pvTotal. It divides the buckets of oSymTable among uThreads threads,
+ one of them the calling thread, and each thread i applies *pfApply to the bindings in its buckets, passing ppvExtras[i] as the extra argument.
+ Since no two threads share an extra, *pfApply can accumulate into it without locking. Once every thread is done, if pfReduce is not NULL,
+ it calls (*pfReduce)(ppvExtras[i], pvTotal) for each i in order. oSymTable must not be modified until it returns. Provided by symtablehash.c. */
+void SymTable_mapParallel(SymTable_T oSymTable, size_t uThreads, void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra), void *ppvExtras[], void (*pfReduce)(void *pvExtra, void *pvTotal), void *pvTotal);
 #endif
@@ -0,0 +1,237 @@
+/* This code implements a slab allocator for symbol table bindings. Small blocks are carved from chunks and recycled through one free list per size class. Blocks too big for any size class are allocated individually and kept on a list so that SymTableArena_free can still release them. */
+
+#include <assert.h>
+#include <stdlib.h>
+#include "symtablearena.h"
+
+/* Block sizes are rounded up to a multiple of GRANULE bytes, which
+ also keeps every block aligned to GRANULE. */
+enum {GRANULE = 16};
+
+/* Size classes cover blocks of 1 to NUM_CLASSES granules. */
+enum {NUM_CLASSES = 32};
+
+/* The first chunk holds FIRST_CHUNK_SIZE bytes, and each later chunk
+ doubles in size up to MAX_CHUNK_SIZE, so small tables stay small. */
+enum {FIRST_CHUNK_SIZE = 1024, MAX_CHUNK_SIZE = 65536};
+
+/* Round uSize up to a multiple of GRANULE. */
+#define ROUND_UP(uSize) (((uSize) + GRANULE - 1) / GRANULE * GRANULE)
+
+/* A released block is reused as a link in its size class's free list. */
+struct SymTableArena_Free
+{
+  /* Next released block of the same size class */
+  struct SymTableArena_Free *next;
+};
+
+/* Each chunk begins with a SymTableArena_Chunk header. */
+struct SymTableArena_Chunk
+{
+  /* Chunk allocated before this one */
+  struct SymTableArena_Chunk *next;
+};
+
+/* Each block too big for a size class begins with a
+ SymTableArena_Large header. Large blocks form a doubly linked list. */
+struct SymTableArena_Large
+{
+  /* Previous large block, or NULL */
+  struct SymTableArena_Large *prev;
+  /* Next large block, or NULL */
+  struct SymTableArena_Large *next;
+};
+
+/* Begins arena */
+struct SymTableArena
+{
+  /* Every chunk, most recent first */
+  struct SymTableArena_Chunk *chunks;
+  /* Every large block */
+  struct SymTableArena_Large *large;
+  /* Next unused byte of the most recent chunk */
+  char *bump;
+  /* One past the last byte of the most recent chunk */
+  char *limit;
+  /* Size of the next chunk to allocate */
+  size_t nextChunkSize;
+  /* freeLists[i] holds released blocks of i + 1 granules */
+  struct SymTableArena_Free *freeLists[NUM_CLASSES];
+};
+
+/* Size of the header at the start of each chunk */
+#define CHUNK_HEADER_SIZE ROUND_UP(sizeof(struct SymTableArena_Chunk))
+
+/* Size of the header at the start of each large block */
+#define LARGE_HEADER_SIZE ROUND_UP(sizeof(struct SymTableArena_Large))
+
+SymTableArena_T SymTableArena_new(void)
+{
+  SymTableArena_T oArena;
+  size_t i;
+
+  oArena = (SymTableArena_T)malloc(sizeof(struct SymTableArena));
+  if (oArena == NULL)
+  {
+    return NULL;
+  }
+
+  oArena->chunks = NULL;
+  oArena->large = NULL;
+  oArena->bump = NULL;
+  oArena->limit = NULL;
+  oArena->nextChunkSize = FIRST_CHUNK_SIZE;
+  for (i = 0; i < NUM_CLASSES; i++)
+  {
+    oArena->freeLists[i] = NULL;
+  }
+
+  return oArena;
+}
+
+void SymTableArena_free(SymTableArena_T oArena)
+{
+  struct SymTableArena_Chunk *chunk;
+  struct SymTableArena_Chunk *nextChunk;
+  struct SymTableArena_Large *large;
+  struct SymTableArena_Large *nextLarge;
+
+  assert(oArena != NULL);
+
+  for (chunk = oArena->chunks; chunk != NULL; chunk = nextChunk)
+  {
+    nextChunk = chunk->next;
+    free(chunk);
+  }
+
+  for (large = oArena->large; large != NULL; large = nextLarge)
+  {
+    nextLarge = large->next;
+    free(large);
+  }
+
+  free(oArena);
+}
+
+/* Allocate a block of uSize bytes, a multiple of GRANULE bytes too big
+   for any size class, from the heap, and link it into oArena's list of
+   large blocks. Return NULL if there is insufficient memory. */
+static void *SymTableArena_allocLarge(SymTableArena_T oArena, size_t uSize)
+{
+  struct SymTableArena_Large *large;
+
+  large = malloc(LARGE_HEADER_SIZE + uSize);
+  if (large == NULL)
+  {
+    return NULL;
+  }
+
+  large->prev = NULL;
+  large->next = oArena->large;
+  if (oArena->large != NULL)
+  {
+    oArena->large->prev = large;
+  }
+  oArena->large = large;
+  return (char*)large + LARGE_HEADER_SIZE;
+}
+
+/* Start a new chunk in oArena big enough for a block of uSize bytes.
+   Return 0 if there is insufficient memory, otherwise 1. */
+static int SymTableArena_addChunk(SymTableArena_T oArena, size_t uSize)
+{
+  struct SymTableArena_Chunk *chunk;
+  size_t chunkSize = oArena->nextChunkSize;
+
+  while (chunkSize < CHUNK_HEADER_SIZE + uSize)
+  {
+    chunkSize *= 2;
+  }
+
+  chunk = malloc(chunkSize);
+  if (chunk == NULL)
+  {
+    return 0;
+  }
+
+  chunk->next = oArena->chunks;
+  oArena->chunks = chunk;
+  oArena->bump = (char*)chunk + CHUNK_HEADER_SIZE;
+  oArena->limit = (char*)chunk + chunkSize;
+  if (oArena->nextChunkSize < MAX_CHUNK_SIZE)
+  {
+    oArena->nextChunkSize *= 2;
+  }
+  return 1;
+}
+
+void *SymTableArena_alloc(SymTableArena_T oArena, size_t uSize)
+{
+  struct SymTableArena_Free *block;
+  size_t sizeClass;
+
+  assert(oArena != NULL);
+  assert(uSize > 0);
+
+  uSize = ROUND_UP(uSize);
+  sizeClass = uSize / GRANULE - 1;
+  if (sizeClass >= NUM_CLASSES)
+  {
+    return SymTableArena_allocLarge(oArena, uSize);
+  }
+
+  /* reuse a released block if there is one */
+  block = oArena->freeLists[sizeClass];
+  if (block != NULL)
+  {
+    oArena->freeLists[sizeClass] = block->next;
+    return block;
+  }
+
+  if ((size_t)(oArena->limit - oArena->bump) < uSize)
+  {
+    if (! SymTableArena_addChunk(oArena, uSize))
+    {
+      return NULL;
+    }
+  }
+
+  block = (struct SymTableArena_Free*)oArena->bump;
+  oArena->bump += uSize;
+  return block;
+}
+
+void SymTableArena_release(SymTableArena_T oArena, void *pvBlock, size_t uSize)
+{
+  struct SymTableArena_Free *block;
+  struct SymTableArena_Large *large;
+  size_t sizeClass;
+
+  assert(oArena != NULL);
+  assert(pvBlock != NULL);
+
+  uSize = ROUND_UP(uSize);
+  sizeClass = uSize / GRANULE - 1;
+  if (sizeClass >= NUM_CLASSES)
+  {
+    large = (struct SymTableArena_Large*)((char*)pvBlock - LARGE_HEADER_SIZE);
+    if (large->prev != NULL)
+    {
+      large->prev->next = large->next;
+    }
+    else
+    {
+      oArena->large = large->next;
+    }
+    if (large->next != NULL)
+    {
+      large->next->prev = large->prev;
+    }
+    free(large);
+    return;
+  }
+
+  block = pvBlock;
+  block->next = oArena->freeLists[sizeClass];
+  oArena->freeLists[sizeClass] = block;
+}
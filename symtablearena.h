@@ -0,0 +1,22 @@
+/* Interface for symtablearena.c, a slab allocator that symtablelist.c and symtablehash.c use for their bindings. */
+#include <stddef.h>
+#ifndef SYMTABLEARENA_INCLUDED
+#define SYMTABLEARENA_INCLUDED
+/* A SymTableArena_T hands out blocks carved from large chunks of memory. Released blocks are kept on free lists by size and reused, and all blocks are freed at once when the arena is freed. */
+typedef struct SymTableArena *SymTableArena_T;
+/* SymTableArena_new is a function that takes no arguments and
+returns a new SymTableArena_T with no blocks.
+If there is insufficient memory, it returns NULL. */
+SymTableArena_T SymTableArena_new(void);
+/* SymTableArena_free is a function that takes one argument,
+a SymTableArena_T type oArena, and frees all memory occupied by oArena, including every block it handed out. */
+void SymTableArena_free(SymTableArena_T oArena);
+/* SymTableArena_alloc is a function that takes two arguments, a SymTableArena_T type oArena and a size_t uSize.
+ It returns a block of at least uSize bytes, suitably aligned for any structure of pointers and size_t values.
+ If there is insufficient memory, it returns NULL. */
+void *SymTableArena_alloc(SymTableArena_T oArena, size_t uSize);
+/* SymTableArena_release is a function that takes three arguments, a SymTableArena_T type oArena, a pointer pvBlock,
+ and a size_t uSize. pvBlock must have been returned by SymTableArena_alloc(oArena, uSize).
+ The block is returned to oArena for reuse by a later SymTableArena_alloc. */
+void SymTableArena_release(SymTableArena_T oArena, void *pvBlock, size_t uSize);
+#endif
@@ -0,0 +1,994 @@
+/* This code implements a symbol table using an adaptive radix tree. Each inner node branches on one byte of the key and grows through four sizes (Node4, Node16, Node48, and Node256) as children are added. Path compression stores the bytes that all keys below an inner node share once, in that node, so a leaf holds only the part of its key that no other key shares. Lookups follow the key's bytes down the tree without hashing, and SymTable_map visits bindings in ascending key order. SymTable_map reassembles each key in a buffer that it reuses for the next, so pcKey is only valid until *pfApply returns, and *pfApply must not put or remove bindings of the table or map it again, though it may replace values. */
+
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+#include "symtable.h"
+#include "symtablearena.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* Kinds of node. The inner node kinds are in order of capacity, so
+ an inner node grows into the next kind and shrinks into the previous. */
+enum SymTable_Kind {LEAF, NODE4, NODE16, NODE48, NODE256};
+
+/* An inner node shrinks into the previous kind once its children
+ number SHRINK_NODE16, SHRINK_NODE48, or SHRINK_NODE256, a few less than
+ the previous kind holds, so that alternately adding and removing a
+ child does not resize it every time. */
+enum {SHRINK_NODE16 = 3, SHRINK_NODE48 = 12, SHRINK_NODE256 = 37};
+
+/* Every node begins with a SymTable_Node structure giving its kind. */
+struct SymTable_Node
+{
+  /* One of enum SymTable_Kind */
+  unsigned char kind;
+};
+
+/* Each key-value binding pair is stored in a leaf. A key's bytes are
+ taken to include its terminating '\0', so no key is a prefix of another
+ and every binding ends in a leaf of its own. */
+struct SymTable_Leaf
+{
+  struct SymTable_Node node;
+  /* Values stored in void pointer. */
+  void *value;
+  /* Number of bytes in suffix */
+  size_t length;
+  /* The bytes of the key after those that the path to the leaf spells,
+     ending with the key's '\0' unless the path spells the '\0' itself */
+  unsigned char suffix[];
+};
+
+/* Each inner node begins with a SymTable_Inner structure. Its prefix
+ bytes trail the node in the same allocation. */
+struct SymTable_Inner
+{
+  struct SymTable_Node node;
+  /* Number of children */
+  unsigned short count;
+  /* Number of bytes in prefix */
+  size_t prefixLength;
+  /* The bytes that every key below the node shares after the bytes
+     that the path to the node spells. They never include a '\0'. */
+  unsigned char *prefix;
+};
+
+/* Inner node with up to 4 children, keys sorted ascending */
+struct SymTable_Node4
+{
+  struct SymTable_Inner inner;
+  unsigned char keys[4];
+  struct SymTable_Node *children[4];
+};
+
+/* Inner node with up to 16 children, keys sorted ascending */
+struct SymTable_Node16
+{
+  struct SymTable_Inner inner;
+  unsigned char keys[16];
+  struct SymTable_Node *children[16];
+};
+
+/* Inner node with up to 48 children. index[b] is 0 if there is no child
+ for byte b, or one more than the child's position in children. */
+struct SymTable_Node48
+{
+  struct SymTable_Inner inner;
+  unsigned char index[256];
+  struct SymTable_Node *children[48];
+};
+
+/* Inner node with a child slot for every byte */
+struct SymTable_Node256
+{
+  struct SymTable_Inner inner;
+  struct SymTable_Node *children[256];
+};
+
+/* Begins radix tree */
+struct SymTable
+{
+  /* Number of bindings is the length */
+  size_t length;
+  /* Root of the tree, or NULL if there are no bindings */
+  struct SymTable_Node *root;
+  /* Buffer in which SymTable_map reassembles each key, with room for
+     the longest key ever put */
+  char *keyBuffer;
+  size_t keyBufferSize;
+  /* Nonzero while SymTable_map walks the tree */
+  int mapping;
+  /* Arena that holds every node */
+  SymTableArena_T arena;
+};
+
+/* Return the size of an inner node of kind eKind, excluding its prefix. */
+static size_t SymTable_innerSize(enum SymTable_Kind eKind)
+{
+  switch (eKind)
+  {
+    case NODE4:
+      return sizeof(struct SymTable_Node4);
+    case NODE16:
+      return sizeof(struct SymTable_Node16);
+    case NODE48:
+      return sizeof(struct SymTable_Node48);
+    default:
+      return sizeof(struct SymTable_Node256);
+  }
+}
+
+/* Return the number of children an inner node of kind eKind can hold. */
+static size_t SymTable_capacity(enum SymTable_Kind eKind)
+{
+  switch (eKind)
+  {
+    case NODE4:
+      return 4;
+    case NODE16:
+      return 16;
+    case NODE48:
+      return 48;
+    default:
+      return 256;
+  }
+}
+
+/* Return a new leaf of oSymTable with value pvValue whose suffix is the
+   uLength bytes at pucSuffix, or NULL if there is insufficient memory. */
+static struct SymTable_Leaf *SymTable_newLeaf(SymTable_T oSymTable, const unsigned char *pucSuffix, size_t uLength, const void *pvValue)
+{
+  struct SymTable_Leaf *leaf;
+
+  leaf = SymTableArena_alloc(oSymTable->arena,
+                             sizeof(struct SymTable_Leaf) + uLength);
+  if (leaf == NULL)
+  {
+    return NULL;
+  }
+  leaf->node.kind = LEAF;
+  leaf->value = (void*) pvValue;
+  leaf->length = uLength;
+  memcpy(leaf->suffix, pucSuffix, uLength);
+  return leaf;
+}
+
+/* Return a new inner node of oSymTable of kind eKind with no children
+   whose prefix is the uPrefixLength bytes at pucPrefix, or NULL if
+   there is insufficient memory. */
+static struct SymTable_Inner *SymTable_newInner(SymTable_T oSymTable, enum SymTable_Kind eKind, const unsigned char *pucPrefix, size_t uPrefixLength)
+{
+  struct SymTable_Inner *inner;
+  size_t size = SymTable_innerSize(eKind);
+  size_t i;
+
+  inner = SymTableArena_alloc(oSymTable->arena, size + uPrefixLength);
+  if (inner == NULL)
+  {
+    return NULL;
+  }
+  inner->node.kind = (unsigned char)eKind;
+  inner->count = 0;
+  inner->prefixLength = uPrefixLength;
+  inner->prefix = (unsigned char*)inner + size;
+  memcpy(inner->prefix, pucPrefix, uPrefixLength);
+
+  if (eKind == NODE48)
+  {
+    memset(((struct SymTable_Node48*)inner)->index, 0, 256);
+  }
+  else if (eKind == NODE256)
+  {
+    for (i = 0; i < 256; i++)
+    {
+      ((struct SymTable_Node256*)inner)->children[i] = NULL;
+    }
+  }
+  return inner;
+}
+
+/* Return node, which oSymTable no longer uses, to its arena. */
+static void SymTable_release(SymTable_T oSymTable, struct SymTable_Node *node)
+{
+  struct SymTable_Inner *inner;
+
+  if (node->kind == LEAF)
+  {
+    SymTableArena_release(oSymTable->arena, node, sizeof(struct SymTable_Leaf)
+                          + ((struct SymTable_Leaf*)node)->length);
+    return;
+  }
+  inner = (struct SymTable_Inner*)node;
+  SymTableArena_release(oSymTable->arena, node,
+                        SymTable_innerSize((enum SymTable_Kind)node->kind)
+                        + inner->prefixLength);
+}
+
+/* Return the address of the child of inner for byte ucByte, or NULL if
+   there is no such child. */
+static struct SymTable_Node **SymTable_findChild(struct SymTable_Inner *inner, unsigned char ucByte)
+{
+  struct SymTable_Node4 *node4;
+  struct SymTable_Node16 *node16;
+  struct SymTable_Node48 *node48;
+  struct SymTable_Node256 *node256;
+  size_t i;
+#ifdef __SSE2__
+  unsigned mask;
+#endif
+
+  switch (inner->node.kind)
+  {
+    case NODE4:
+      node4 = (struct SymTable_Node4*)inner;
+      for (i = 0; i < inner->count; i++)
+      {
+        if (node4->keys[i] == ucByte)
+        {
+          return &node4->children[i];
+        }
+      }
+      return NULL;
+
+    case NODE16:
+      node16 = (struct SymTable_Node16*)inner;
+#ifdef __SSE2__
+      /* compare all sixteen keys at once */
+      mask = (unsigned)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(_mm_set1_epi8((char)ucByte),
+                       _mm_loadu_si128((const __m128i*)node16->keys)));
+      mask &= (1U << inner->count) - 1;
+      if (mask == 0)
+      {
+        return NULL;
+      }
+      return &node16->children[__builtin_ctz(mask)];
+#else
+      for (i = 0; i < inner->count; i++)
+      {
+        if (node16->keys[i] == ucByte)
+        {
+          return &node16->children[i];
+        }
+      }
+      return NULL;
+#endif
+
+    case NODE48:
+      node48 = (struct SymTable_Node48*)inner;
+      if (node48->index[ucByte] == 0)
+      {
+        return NULL;
+      }
+      return &node48->children[node48->index[ucByte] - 1];
+
+    default:
+      node256 = (struct SymTable_Node256*)inner;
+      if (node256->children[ucByte] == NULL)
+      {
+        return NULL;
+      }
+      return &node256->children[ucByte];
+  }
+}
+
+/* SymTable_nextChild returns the child of inner for the smallest byte
+that is at least *puByte, and sets *puByte to that byte. It returns NULL
+if there is no such child. */
+static struct SymTable_Node *SymTable_nextChild(struct SymTable_Inner *inner, size_t *puByte)
+{
+  struct SymTable_Node4 *node4;
+  struct SymTable_Node16 *node16;
+  struct SymTable_Node48 *node48;
+  struct SymTable_Node256 *node256;
+  size_t i;
+
+  switch (inner->node.kind)
+  {
+    case NODE4:
+      node4 = (struct SymTable_Node4*)inner;
+      for (i = 0; i < inner->count; i++)
+      {
+        if (node4->keys[i] >= *puByte)
+        {
+          *puByte = node4->keys[i];
+          return node4->children[i];
+        }
+      }
+      return NULL;
+
+    case NODE16:
+      node16 = (struct SymTable_Node16*)inner;
+      for (i = 0; i < inner->count; i++)
+      {
+        if (node16->keys[i] >= *puByte)
+        {
+          *puByte = node16->keys[i];
+          return node16->children[i];
+        }
+      }
+      return NULL;
+
+    case NODE48:
+      node48 = (struct SymTable_Node48*)inner;
+      for (i = *puByte; i < 256; i++)
+      {
+        if (node48->index[i] != 0)
+        {
+          *puByte = i;
+          return node48->children[node48->index[i] - 1];
+        }
+      }
+      return NULL;
+
+    default:
+      node256 = (struct SymTable_Node256*)inner;
+      for (i = *puByte; i < 256; i++)
+      {
+        if (node256->children[i] != NULL)
+        {
+          *puByte = i;
+          return node256->children[i];
+        }
+      }
+      return NULL;
+  }
+}
+
+/* Add child to inner as the child for byte ucByte. inner must have
+   room for it and no child for ucByte already. */
+static void SymTable_insertChild(struct SymTable_Inner *inner, unsigned char ucByte, struct SymTable_Node *child)
+{
+  unsigned char *keys;
+  struct SymTable_Node **children;
+  struct SymTable_Node48 *node48;
+  size_t i;
+
+  switch (inner->node.kind)
+  {
+    case NODE4:
+    case NODE16:
+      if (inner->node.kind == NODE4)
+      {
+        keys = ((struct SymTable_Node4*)inner)->keys;
+        children = ((struct SymTable_Node4*)inner)->children;
+      }
+      else
+      {
+        keys = ((struct SymTable_Node16*)inner)->keys;
+        children = ((struct SymTable_Node16*)inner)->children;
+      }
+      /* keep the keys sorted */
+      for (i = inner->count; i > 0 && keys[i - 1] > ucByte; i--)
+      {
+        keys[i] = keys[i - 1];
+        children[i] = children[i - 1];
+      }
+      keys[i] = ucByte;
+      children[i] = child;
+      break;
+
+    case NODE48:
+      node48 = (struct SymTable_Node48*)inner;
+      node48->children[inner->count] = child;
+      node48->index[ucByte] = (unsigned char)(inner->count + 1);
+      break;
+
+    default:
+      ((struct SymTable_Node256*)inner)->children[ucByte] = child;
+      break;
+  }
+  inner->count++;
+}
+
+/* Remove the child of inner for byte ucByte, which must exist. */
+static void SymTable_deleteChild(struct SymTable_Inner *inner, unsigned char ucByte)
+{
+  unsigned char *keys;
+  struct SymTable_Node **children;
+  struct SymTable_Node48 *node48;
+  size_t position;
+  size_t last;
+  size_t i;
+
+  switch (inner->node.kind)
+  {
+    case NODE4:
+    case NODE16:
+      if (inner->node.kind == NODE4)
+      {
+        keys = ((struct SymTable_Node4*)inner)->keys;
+        children = ((struct SymTable_Node4*)inner)->children;
+      }
+      else
+      {
+        keys = ((struct SymTable_Node16*)inner)->keys;
+        children = ((struct SymTable_Node16*)inner)->children;
+      }
+      for (position = 0; keys[position] != ucByte; position++)
+      {
+      }
+      for (i = position + 1; i < inner->count; i++)
+      {
+        keys[i - 1] = keys[i];
+        children[i - 1] = children[i];
+      }
+      break;
+
+    case NODE48:
+      /* move the last child into the freed position, so that the
+         children stay contiguous */
+      node48 = (struct SymTable_Node48*)inner;
+      position = node48->index[ucByte] - 1;
+      last = inner->count - 1;
+      node48->index[ucByte] = 0;
+      if (position != last)
+      {
+        node48->children[position] = node48->children[last];
+        for (i = 0; node48->index[i] != last + 1; i++)
+        {
+        }
+        node48->index[i] = (unsigned char)(position + 1);
+      }
+      break;
+
+    default:
+      ((struct SymTable_Node256*)inner)->children[ucByte] = NULL;
+      break;
+  }
+  inner->count--;
+}
+
+/* Return a new inner node of oSymTable of kind eKind, whose prefix is
+   the uPrefixLength bytes at pucPrefix and whose children are those of
+   inner, or NULL if there is insufficient memory. inner is unchanged. */
+static struct SymTable_Inner *SymTable_copyInner(SymTable_T oSymTable, struct SymTable_Inner *inner, enum SymTable_Kind eKind, const unsigned char *pucPrefix, size_t uPrefixLength)
+{
+  struct SymTable_Inner *copy;
+  struct SymTable_Node *child;
+  size_t byte;
+
+  copy = SymTable_newInner(oSymTable, eKind, pucPrefix, uPrefixLength);
+  if (copy == NULL)
+  {
+    return NULL;
+  }
+  for (byte = 0; (child = SymTable_nextChild(inner, &byte)) != NULL; byte++)
+  {
+    SymTable_insertChild(copy, (unsigned char)byte, child);
+  }
+  return copy;
+}
+
+/* Add child to the inner node at *ppsSlot as its child for byte ucByte,
+   growing the node into the next kind if it is full. Return 0 if there
+   is insufficient memory, otherwise 1. */
+static int SymTable_addChild(SymTable_T oSymTable, struct SymTable_Node **ppsSlot, unsigned char ucByte, struct SymTable_Node *child)
+{
+  struct SymTable_Inner *inner = (struct SymTable_Inner*)*ppsSlot;
+  struct SymTable_Inner *bigger;
+
+  if (inner->count == SymTable_capacity((enum SymTable_Kind)inner->node.kind))
+  {
+    bigger = SymTable_copyInner(oSymTable, inner,
+                                (enum SymTable_Kind)(inner->node.kind + 1),
+                                inner->prefix, inner->prefixLength);
+    if (bigger == NULL)
+    {
+      return 0;
+    }
+    SymTable_release(oSymTable, &inner->node);
+    *ppsSlot = &bigger->node;
+    inner = bigger;
+  }
+  SymTable_insertChild(inner, ucByte, child);
+  return 1;
+}
+
+/* Remove the child for byte ucByte from the inner node at *ppsSlot.
+   Then shrink the node into the previous kind if it has few children,
+   or merge it into its only child. Those steps are skipped if there is
+   insufficient memory, which leaves a valid but larger tree. */
+static void SymTable_removeChild(SymTable_T oSymTable, struct SymTable_Node **ppsSlot, unsigned char ucByte)
+{
+  struct SymTable_Inner *inner = (struct SymTable_Inner*)*ppsSlot;
+  struct SymTable_Inner *smaller;
+  struct SymTable_Inner *childInner = NULL;
+  struct SymTable_Leaf *childLeaf = NULL;
+  struct SymTable_Node *merged;
+  struct SymTable_Node *child;
+  unsigned char *bytes;
+  size_t length;
+  size_t byte = 0;
+
+  SymTable_deleteChild(inner, ucByte);
+
+  if (inner->node.kind == NODE4 && inner->count == 1)
+  {
+    /* path compression: the node's prefix, the byte to its child, and
+       the child's own prefix or suffix become the child's */
+    child = SymTable_nextChild(inner, &byte);
+    if (child->kind == LEAF)
+    {
+      childLeaf = (struct SymTable_Leaf*)child;
+      length = inner->prefixLength + 1 + childLeaf->length;
+    }
+    else
+    {
+      childInner = (struct SymTable_Inner*)child;
+      length = inner->prefixLength + 1 + childInner->prefixLength;
+    }
+    bytes = malloc(length);
+    if (bytes == NULL)
+    {
+      return;
+    }
+    memcpy(bytes, inner->prefix, inner->prefixLength);
+    bytes[inner->prefixLength] = (unsigned char)byte;
+    if (child->kind == LEAF)
+    {
+      memcpy(bytes + inner->prefixLength + 1, childLeaf->suffix,
+             childLeaf->length);
+      merged = (struct SymTable_Node*)SymTable_newLeaf(oSymTable, bytes, length,
+                                                       childLeaf->value);
+    }
+    else
+    {
+      memcpy(bytes + inner->prefixLength + 1, childInner->prefix,
+             childInner->prefixLength);
+      merged = (struct SymTable_Node*)SymTable_copyInner(
+        oSymTable, childInner, (enum SymTable_Kind)child->kind, bytes, length);
+    }
+    free(bytes);
+    if (merged == NULL)
+    {
+      return;
+    }
+    SymTable_release(oSymTable, child);
+    SymTable_release(oSymTable, &inner->node);
+    *ppsSlot = merged;
+    return;
+  }
+
+  if ((inner->node.kind == NODE16 && inner->count <= SHRINK_NODE16)
+      || (inner->node.kind == NODE48 && inner->count <= SHRINK_NODE48)
+      || (inner->node.kind == NODE256 && inner->count <= SHRINK_NODE256))
+  {
+    smaller = SymTable_copyInner(oSymTable, inner,
+                                 (enum SymTable_Kind)(inner->node.kind - 1),
+                                 inner->prefix, inner->prefixLength);
+    if (smaller == NULL)
+    {
+      return;
+    }
+    SymTable_release(oSymTable, &inner->node);
+    *ppsSlot = &smaller->node;
+  }
+}
+
+/* Return the number of leading bytes of the prefix of inner that match
+   the bytes at pucKey. The comparison stops at pucKey's '\0', since no
+   prefix contains one. */
+static size_t SymTable_matchPrefix(struct SymTable_Inner *inner, const unsigned char *pucKey)
+{
+  size_t i;
+
+  for (i = 0; i < inner->prefixLength && inner->prefix[i] == pucKey[i]; i++)
+  {
+  }
+  return i;
+}
+
+/* SymTable_find returns the leaf of oSymTable whose key is pcKey, or
+NULL if there is no such leaf. */
+static struct SymTable_Leaf *SymTable_find(SymTable_T oSymTable, const char *pcKey)
+{
+  const unsigned char *key = (const unsigned char*)pcKey;
+  struct SymTable_Node *node = oSymTable->root;
+  struct SymTable_Node **child;
+  struct SymTable_Inner *inner;
+  struct SymTable_Leaf *leaf;
+  size_t depth = 0;
+
+  while (node != NULL)
+  {
+    if (node->kind == LEAF)
+    {
+      /* a leaf without a suffix hangs from its key's '\0' */
+      leaf = (struct SymTable_Leaf*)node;
+      if (leaf->length == 0
+          || strcmp((const char*)leaf->suffix, pcKey + depth) == 0)
+      {
+        return leaf;
+      }
+      return NULL;
+    }
+
+    inner = (struct SymTable_Inner*)node;
+    if (SymTable_matchPrefix(inner, key + depth) != inner->prefixLength)
+    {
+      return NULL;
+    }
+    depth += inner->prefixLength;
+
+    child = SymTable_findChild(inner, key[depth]);
+    if (child == NULL)
+    {
+      return NULL;
+    }
+    node = *child;
+    depth++;
+  }
+  return NULL;
+}
+
+SymTable_T SymTable_new(void)
+{
+  SymTable_T oSymTable;
+
+  oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+  if (oSymTable == NULL)
+  {
+    return NULL;
+  }
+
+  oSymTable->arena = SymTableArena_new();
+  if (oSymTable->arena == NULL)
+  {
+    free(oSymTable);
+    return NULL;
+  }
+
+  oSymTable->length = 0;
+  oSymTable->root = NULL;
+  oSymTable->keyBuffer = NULL;
+  oSymTable->keyBufferSize = 0;
+  oSymTable->mapping = 0;
+  return oSymTable;
+}
+
+void SymTable_free(SymTable_T oSymTable)
+{
+  assert(oSymTable != NULL);
+
+  /* every node lives in the arena, so the tree need not be walked */
+  SymTableArena_free(oSymTable->arena);
+  free(oSymTable->keyBuffer);
+  free(oSymTable);
+}
+
+/* Make the key buffer of oSymTable hold at least uLength bytes. Return
+   1 if successful, or 0 if there is insufficient memory. */
+static int SymTable_reserveKey(SymTable_T oSymTable, size_t uLength)
+{
+  char *keyBuffer;
+
+  if (uLength <= oSymTable->keyBufferSize)
+  {
+    return 1;
+  }
+
+  keyBuffer = malloc(uLength);
+  if (keyBuffer == NULL)
+  {
+    return 0;
+  }
+  free(oSymTable->keyBuffer);
+  oSymTable->keyBuffer = keyBuffer;
+  oSymTable->keyBufferSize = uLength;
+  return 1;
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+  assert(oSymTable != NULL);
+
+  return oSymTable->length;
+}
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue)
+{
+  const unsigned char *key = (const unsigned char*)pcKey;
+  struct SymTable_Node **slot = &oSymTable->root;
+  struct SymTable_Node **child;
+  struct SymTable_Node *node;
+  struct SymTable_Inner *inner;
+  struct SymTable_Inner *split;
+  struct SymTable_Inner *rest;
+  struct SymTable_Leaf *leaf;
+  struct SymTable_Leaf *newLeaf;
+  struct SymTable_Leaf *oldLeaf;
+  size_t keyLength;
+  size_t depth = 0;
+  size_t i;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+  assert(! oSymTable->mapping);
+
+  /* key bytes include the '\0'. Each branch that inserts the key first
+     makes room for it in the key buffer of SymTable_map. */
+  keyLength = strlen(pcKey) + 1;
+
+  for (;;)
+  {
+    node = *slot;
+    if (node == NULL)
+    {
+      if (! SymTable_reserveKey(oSymTable, keyLength))
+      {
+        return 0;
+      }
+      newLeaf = SymTable_newLeaf(oSymTable, key + depth, keyLength - depth,
+                                 pvValue);
+      if (newLeaf == NULL)
+      {
+        return 0;
+      }
+      *slot = &newLeaf->node;
+      break;
+    }
+
+    if (node->kind == LEAF)
+    {
+      /* both suffixes end with '\0', so unless they are equal they
+         differ before either ends */
+      leaf = (struct SymTable_Leaf*)node;
+      for (i = 0; i < leaf->length && i < keyLength - depth
+             && leaf->suffix[i] == key[depth + i]; i++)
+      {
+      }
+      if (i == leaf->length && i == keyLength - depth)
+      {
+        return 0;
+      }
+      if (! SymTable_reserveKey(oSymTable, keyLength))
+      {
+        return 0;
+      }
+
+      /* replace the leaf with a Node4 holding their shared bytes */
+      split = SymTable_newInner(oSymTable, NODE4, key + depth, i);
+      newLeaf = SymTable_newLeaf(oSymTable, key + depth + i + 1,
+                                 keyLength - depth - i - 1, pvValue);
+      oldLeaf = SymTable_newLeaf(oSymTable, leaf->suffix + i + 1,
+                                 leaf->length - i - 1, leaf->value);
+      if (split == NULL || newLeaf == NULL || oldLeaf == NULL)
+      {
+        if (split != NULL)
+        {
+          SymTable_release(oSymTable, &split->node);
+        }
+        if (newLeaf != NULL)
+        {
+          SymTable_release(oSymTable, &newLeaf->node);
+        }
+        if (oldLeaf != NULL)
+        {
+          SymTable_release(oSymTable, &oldLeaf->node);
+        }
+        return 0;
+      }
+      SymTable_insertChild(split, key[depth + i], &newLeaf->node);
+      SymTable_insertChild(split, leaf->suffix[i], &oldLeaf->node);
+      SymTable_release(oSymTable, node);
+      *slot = &split->node;
+      break;
+    }
+
+    inner = (struct SymTable_Inner*)node;
+    i = SymTable_matchPrefix(inner, key + depth);
+    if (i < inner->prefixLength)
+    {
+      /* the key leaves the prefix after i bytes, so a Node4 holding
+         those bytes goes above inner, which keeps the rest */
+      if (! SymTable_reserveKey(oSymTable, keyLength))
+      {
+        return 0;
+      }
+      split = SymTable_newInner(oSymTable, NODE4, inner->prefix, i);
+      rest = SymTable_copyInner(oSymTable, inner,
+                                (enum SymTable_Kind)inner->node.kind,
+                                inner->prefix + i + 1,
+                                inner->prefixLength - i - 1);
+      newLeaf = SymTable_newLeaf(oSymTable, key + depth + i + 1,
+                                 keyLength - depth - i - 1, pvValue);
+      if (split == NULL || rest == NULL || newLeaf == NULL)
+      {
+        if (split != NULL)
+        {
+          SymTable_release(oSymTable, &split->node);
+        }
+        if (rest != NULL)
+        {
+          SymTable_release(oSymTable, &rest->node);
+        }
+        if (newLeaf != NULL)
+        {
+          SymTable_release(oSymTable, &newLeaf->node);
+        }
+        return 0;
+      }
+      SymTable_insertChild(split, inner->prefix[i], &rest->node);
+      SymTable_insertChild(split, key[depth + i], &newLeaf->node);
+      SymTable_release(oSymTable, node);
+      *slot = &split->node;
+      break;
+    }
+    depth += inner->prefixLength;
+
+    child = SymTable_findChild(inner, key[depth]);
+    if (child == NULL)
+    {
+      if (! SymTable_reserveKey(oSymTable, keyLength))
+      {
+        return 0;
+      }
+      newLeaf = SymTable_newLeaf(oSymTable, key + depth + 1,
+                                 keyLength - depth - 1, pvValue);
+      if (newLeaf == NULL)
+      {
+        return 0;
+      }
+      if (! SymTable_addChild(oSymTable, slot, key[depth], &newLeaf->node))
+      {
+        SymTable_release(oSymTable, &newLeaf->node);
+        return 0;
+      }
+      break;
+    }
+    slot = child;
+    depth++;
+  }
+
+  oSymTable->length++;
+  return 1;
+}
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue)
+{
+  struct SymTable_Leaf *found;
+  void *oldVal;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  found = SymTable_find(oSymTable, pcKey);
+  if (found == NULL)
+  {
+    return NULL;
+  }
+
+  oldVal = found->value;
+  found->value = (void*) pvValue;
+  return oldVal;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  return SymTable_find(oSymTable, pcKey) != NULL;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+  struct SymTable_Leaf *found;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  found = SymTable_find(oSymTable, pcKey);
+  if (found == NULL)
+  {
+    return NULL;
+  }
+  return found->value;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+  const unsigned char *key = (const unsigned char*)pcKey;
+  struct SymTable_Node **slot = &oSymTable->root;
+  struct SymTable_Node **parentSlot = NULL;
+  struct SymTable_Node **child;
+  struct SymTable_Node *node;
+  struct SymTable_Inner *inner;
+  struct SymTable_Leaf *leaf;
+  void *holdVal;
+  size_t depth = 0;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+  assert(! oSymTable->mapping);
+
+  for (node = *slot; node != NULL && node->kind != LEAF; node = *slot)
+  {
+    inner = (struct SymTable_Inner*)node;
+    if (SymTable_matchPrefix(inner, key + depth) != inner->prefixLength)
+    {
+      return NULL;
+    }
+    depth += inner->prefixLength;
+
+    child = SymTable_findChild(inner, key[depth]);
+    if (child == NULL)
+    {
+      return NULL;
+    }
+    parentSlot = slot;
+    slot = child;
+    depth++;
+  }
+  if (node == NULL)
+  {
+    return NULL;
+  }
+
+  leaf = (struct SymTable_Leaf*)node;
+  if (leaf->length != 0
+      && strcmp((const char*)leaf->suffix, pcKey + depth) != 0)
+  {
+    return NULL;
+  }
+
+  holdVal = leaf->value;
+  if (parentSlot == NULL)
+  {
+    oSymTable->root = NULL;
+  }
+  else
+  {
+    SymTable_removeChild(oSymTable, parentSlot, key[depth - 1]);
+  }
+  SymTable_release(oSymTable, node);
+  oSymTable->length--;
+  return holdVal;
+}
+
+/* SymTable_mapNode applies *pfApply to each binding below node, whose
+path spells the first uDepth bytes in the key buffer of oSymTable, in
+ascending key order, passing pvExtra. */
+static void SymTable_mapNode(SymTable_T oSymTable, struct SymTable_Node *node, size_t uDepth, void(*pfApply)(const char *pcKey, void *pvValue, void *pvExtra), void *pvExtra)
+{
+  struct SymTable_Inner *inner;
+  struct SymTable_Leaf *leaf;
+  struct SymTable_Node *child;
+  size_t byte;
+
+  if (node->kind == LEAF)
+  {
+    leaf = (struct SymTable_Leaf*)node;
+    memcpy(oSymTable->keyBuffer + uDepth, leaf->suffix, leaf->length);
+    (*pfApply)(oSymTable->keyBuffer, leaf->value, pvExtra);
+    return;
+  }
+
+  inner = (struct SymTable_Inner*)node;
+  memcpy(oSymTable->keyBuffer + uDepth, inner->prefix, inner->prefixLength);
+  uDepth += inner->prefixLength;
+  for (byte = 0; (child = SymTable_nextChild(inner, &byte)) != NULL; byte++)
+  {
+    oSymTable->keyBuffer[uDepth] = (char)byte;
+    SymTable_mapNode(oSymTable, child, uDepth + 1, pfApply, pvExtra);
+  }
+}
+
+void SymTable_map(SymTable_T oSymTable, void(*pfApply)(const char *pcKey, void *pvValue, void *pvExtra), const void *pvExtra)
+{
+  assert(oSymTable != NULL);
+  assert(pfApply != NULL);
+
+  assert(! oSymTable->mapping);
+
+  oSymTable->mapping = 1;
+  if (oSymTable->root != NULL)
+  {
+    SymTable_mapNode(oSymTable, oSymTable->root, 0, pfApply, (void*)pvExtra);
+  }
+  oSymTable->mapping = 0;
+}
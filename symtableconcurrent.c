@@ -0,0 +1,833 @@
+/* This code implements a symbol table that many threads may use at once. It is the hash table of symtablehash.c with its buckets divided among NUM_STRIPES stripes, each guarded by a reader/writer lock that writers take, so that writers to different stripes never wait for each other. SymTable_get and SymTable_contains take no lock and never wait: writers publish nodes with release stores, an expansion builds a copy of the chains and swaps it in whole, and removed nodes and replaced chains are freed only after an epoch-based grace period guarantees that no lookup can still be reading them. The lock-free lookups rely on the __atomic builtins of GCC and Clang. */
+
+#define _XOPEN_SOURCE 700
+
+#include <assert.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include "symtable.h"
+
+/* Number of stripes. Always a power of two. */
+enum {NUM_STRIPES = 64};
+
+/* Number of buckets in a new SymTable. Always a power of two, and a
+ multiple of NUM_STRIPES. */
+enum {INITIAL_BUCKETS = 512};
+
+/* Size of a cache line. Each reader slot starts one of its own, so
+ that threads announcing lookups never write to the same line. */
+enum {CACHE_LINE = 64};
+
+/* Removed nodes are reclaimed once RECLAIM_THRESHOLD of them have been
+ retired since the last attempt. */
+enum {RECLAIM_THRESHOLD = 64};
+
+/* Number of lists of retired memory. Memory retired in epoch e is kept
+ on list e % EPOCH_LISTS until the epoch reaches e + 2. */
+enum {EPOCH_LISTS = 3};
+
+/* Read, with acquire ordering, and write, with release ordering, a
+ word that lookups may read while a writer changes it. */
+#define LOAD(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define STORE(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+
+/* Each key-value binding pair is stored in a Binding structure.
+ Bindings  are linked with pointers to form a linked list. */
+struct SymTable_Node
+{
+  /* Values stored in void pointer. */
+  void *value;
+  /* Full hash of key, so expansion never rehashes the key. */
+  size_t hash;
+  /* Structure points to next binding in hash table. */
+  struct SymTable_Node *next;
+  /* Next node awaiting reclamation, once the node is removed. It is
+     separate from next because lookups may still be following next. */
+  struct SymTable_Node *retired;
+  /* Key bytes trail the node in the same allocation. */
+  char key[];
+};
+
+/* A bucket array. It is replaced as a whole when the table expands,
+ so that a lookup always reads a count and heads that belong together. */
+struct SymTable_Buckets
+{
+  /* Number of buckets, a power of two */
+  size_t count;
+  /* Next bucket array awaiting reclamation, once it is replaced */
+  struct SymTable_Buckets *retired;
+  /* Head of each bucket's chain */
+  struct SymTable_Node *heads[];
+};
+
+/* Bucket i belongs to stripe i % NUM_STRIPES. Because every bucket
+ count is a multiple of NUM_STRIPES, a binding's stripe is fixed by its
+ hash alone and never changes when the table expands. */
+struct SymTable_Stripe
+{
+  /* Held for writing to change the stripe's buckets, and for reading
+     by SymTable_map */
+  pthread_rwlock_t lock;
+  /* Number of bindings in the stripe's buckets. It changes only
+     under the lock, but SymTable_getLength reads it without. */
+  size_t length;
+};
+
+/* The reader slot of one thread, through which it announces its
+ lookups. Slots are shared by every table, since a thread looks up in
+ at most one at a time, and are handed to new threads as old ones exit. */
+struct SymTable_Reader
+{
+  /* The table of the lookup in progress, or of the last one */
+  SymTable_T table;
+  /* Twice the epoch of table that the lookup in progress entered in,
+     plus one, or 0 between lookups */
+  size_t state;
+  /* Nonzero while a thread owns the slot */
+  int owned;
+  /* Next slot in the list of every slot, which never shrinks */
+  struct SymTable_Reader *next;
+};
+
+/* Begins hash table */
+struct SymTable
+{
+  /* struct Binding begins hash table. Replacing it requires holding
+     every stripe lock for writing. */
+  struct SymTable_Buckets *buckets;
+  /* The current epoch, which only increases */
+  size_t epoch;
+  /* Guards the lists of retired memory, and advancing epoch */
+  pthread_mutex_t reclaimLock;
+  /* Nodes and bucket arrays retired in epoch e, on list e % EPOCH_LISTS */
+  struct SymTable_Node *retiredNodes[EPOCH_LISTS];
+  struct SymTable_Buckets *retiredBuckets[EPOCH_LISTS];
+  /* Number of nodes retired since the last reclamation attempt */
+  size_t retiredCount;
+  /* The stripes */
+  struct SymTable_Stripe stripes[NUM_STRIPES];
+};
+
+/* Every reader slot, and the key under which each thread keeps its
+   own. registryLock guards claiming and adding slots; lookups only
+   follow readers, which is published with release stores. */
+static struct SymTable_Reader *readers = NULL;
+static pthread_mutex_t registryLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t readerKey;
+static pthread_once_t readerKeyOnce = PTHREAD_ONCE_INIT;
+static int readerKeyCreated = 0;
+
+/* Return a hash code for pcKey. Buckets and stripes are both chosen
+   by the low bits of the hash, so the hash must mix well there. */
+static size_t SymTable_hash(const char *pcKey)
+{
+  return SymTable_hashWord(pcKey, 0);
+}
+
+/* Return the stripe of oSymTable that guards the bindings whose hash
+   is uHash. */
+static struct SymTable_Stripe *SymTable_stripe(SymTable_T oSymTable,
+                                               size_t uHash)
+{
+  return &oSymTable->stripes[uHash & (NUM_STRIPES - 1)];
+}
+
+/* Return a new bucket array of uCount empty buckets, or NULL if there
+   is insufficient memory. */
+static struct SymTable_Buckets *SymTable_newBuckets(size_t uCount)
+{
+  struct SymTable_Buckets *buckets;
+
+  if (uCount > (SIZE_MAX - sizeof(struct SymTable_Buckets))
+      / sizeof(struct SymTable_Node*))
+  {
+    return NULL;
+  }
+
+  buckets = calloc(1, sizeof(struct SymTable_Buckets)
+                   + uCount * sizeof(struct SymTable_Node*));
+  if (buckets == NULL)
+  {
+    return NULL;
+  }
+  buckets->count = uCount;
+  return buckets;
+}
+
+/* Return the address of the head of the chain that holds the bindings
+   of buckets whose hash is uHash. */
+static struct SymTable_Node **SymTable_head(struct SymTable_Buckets *buckets,
+                                            size_t uHash)
+{
+  return &buckets->heads[uHash & (buckets->count - 1)];
+}
+
+/* SymTable_search walks the chain that starts at first and returns
+the node whose key is pcKey and whose hash is uHash, or NULL if there
+is no such node. */
+static struct SymTable_Node *SymTable_search(struct SymTable_Node *first,
+                                             const char *pcKey, size_t uHash)
+{
+  struct SymTable_Node *current;
+
+  for (current = first; current != NULL; current = LOAD(&current->next))
+  {
+    if (current->hash == uHash && strcmp(current->key, pcKey) == 0)
+    {
+      return current;
+    }
+  }
+  return NULL;
+}
+
+/* SymTable_find returns the node of oSymTable whose key is pcKey and
+whose hash is uHash, or NULL if there is no such node, without taking
+any lock. The caller must be between SymTable_enter and SymTable_leave,
+or hold the stripe lock of uHash. An expansion never changes the chains
+it replaces, so a lookup that read the old bucket array finishes there. */
+static struct SymTable_Node *SymTable_find(SymTable_T oSymTable,
+                                           const char *pcKey, size_t uHash)
+{
+  return SymTable_search(LOAD(SymTable_head(LOAD(&oSymTable->buckets),
+                                            uHash)), pcKey, uHash);
+}
+
+/* Give up the reader slot pvReader, as the thread that owned it exits. */
+static void SymTable_releaseReader(void *pvReader)
+{
+  struct SymTable_Reader *reader = (struct SymTable_Reader*)pvReader;
+
+  pthread_mutex_lock(&registryLock);
+  reader->owned = 0;
+  pthread_mutex_unlock(&registryLock);
+}
+
+/* Create readerKey, once per process. */
+static void SymTable_createReaderKey(void)
+{
+  readerKeyCreated = pthread_key_create(&readerKey,
+                                        SymTable_releaseReader) == 0;
+}
+
+/* Return the reader slot of the calling thread, claiming or adding one
+   if the thread has none yet, or NULL if there is insufficient memory. */
+static struct SymTable_Reader *SymTable_reader(void)
+{
+  struct SymTable_Reader *reader;
+  size_t size;
+
+  if (pthread_once(&readerKeyOnce, SymTable_createReaderKey) != 0
+      || ! readerKeyCreated)
+  {
+    return NULL;
+  }
+
+  reader = pthread_getspecific(readerKey);
+  if (reader != NULL)
+  {
+    return reader;
+  }
+
+  pthread_mutex_lock(&registryLock);
+
+  for (reader = readers; reader != NULL; reader = reader->next)
+  {
+    if (! reader->owned)
+    {
+      break;
+    }
+  }
+
+  if (reader == NULL)
+  {
+    /* round the slot up to whole cache lines, so no other data shares
+       the lines it starts */
+    size = (sizeof(struct SymTable_Reader) + CACHE_LINE - 1)
+      / CACHE_LINE * CACHE_LINE;
+    if (posix_memalign((void**)&reader, CACHE_LINE, size) != 0)
+    {
+      pthread_mutex_unlock(&registryLock);
+      return NULL;
+    }
+    reader->table = NULL;
+    reader->state = 0;
+    reader->next = readers;
+    STORE(&readers, reader);
+  }
+
+  if (pthread_setspecific(readerKey, reader) != 0)
+  {
+    pthread_mutex_unlock(&registryLock);
+    return NULL;
+  }
+  reader->owned = 1;
+
+  pthread_mutex_unlock(&registryLock);
+  return reader;
+}
+
+/* Announce a lookup in oSymTable of a key whose hash is uHash by the
+   calling thread, so memory it may read is not reclaimed. Return the
+   reader slot to pass to SymTable_leave. A thread that cannot have a
+   slot holds the stripe lock of uHash for reading instead, and NULL is
+   returned. */
+static struct SymTable_Reader *SymTable_enter(SymTable_T oSymTable,
+                                              size_t uHash)
+{
+  struct SymTable_Reader *reader = SymTable_reader();
+  size_t epoch;
+
+  if (reader == NULL)
+  {
+    pthread_rwlock_rdlock(&SymTable_stripe(oSymTable, uHash)->lock);
+    return NULL;
+  }
+
+  /* only this thread writes the slot, so plain stores announce the
+     lookup; the fence orders them before every read of the table,
+     against the fence in SymTable_reclaim */
+  __atomic_store_n(&reader->table, oSymTable, __ATOMIC_RELAXED);
+  epoch = LOAD(&oSymTable->epoch);
+  STORE(&reader->state, 2 * epoch + 1);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  return reader;
+}
+
+/* End the lookup that SymTable_enter announced in reader, of a key
+   whose hash is uHash in oSymTable. */
+static void SymTable_leave(SymTable_T oSymTable,
+                           struct SymTable_Reader *reader, size_t uHash)
+{
+  if (reader == NULL)
+  {
+    pthread_rwlock_unlock(&SymTable_stripe(oSymTable, uHash)->lock);
+    return;
+  }
+  STORE(&reader->state, 0);
+}
+
+/* Free every node and bucket array on the retired lists of oSymTable
+   numbered uList. */
+static void SymTable_freeRetired(SymTable_T oSymTable, size_t uList)
+{
+  struct SymTable_Node *node;
+  struct SymTable_Node *nextNode;
+  struct SymTable_Buckets *buckets;
+  struct SymTable_Buckets *nextBuckets;
+
+  for (node = oSymTable->retiredNodes[uList]; node != NULL; node = nextNode)
+  {
+    nextNode = node->retired;
+    free(node);
+  }
+  oSymTable->retiredNodes[uList] = NULL;
+
+  for (buckets = oSymTable->retiredBuckets[uList]; buckets != NULL;
+       buckets = nextBuckets)
+  {
+    nextBuckets = buckets->retired;
+    free(buckets);
+  }
+  oSymTable->retiredBuckets[uList] = NULL;
+}
+
+/* Advance the epoch of oSymTable, if no lookup that entered in the
+   previous epoch is still in progress, and free the memory that has
+   become unreachable. The caller must hold reclaimLock. */
+static void SymTable_reclaim(SymTable_T oSymTable)
+{
+  struct SymTable_Reader *reader;
+  size_t epoch = oSymTable->epoch;
+  size_t state;
+
+  /* order the unlinking of retired memory before the checks below; a
+     lookup whose announcement they miss reads the table after it */
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+  for (reader = LOAD(&readers); reader != NULL; reader = reader->next)
+  {
+    state = LOAD(&reader->state);
+    if (state % 2 == 1 && state / 2 != epoch
+        && __atomic_load_n(&reader->table, __ATOMIC_RELAXED) == oSymTable)
+    {
+      return;
+    }
+  }
+
+  /* every lookup now entered in epoch or epoch + 1, after anything
+     retired in epoch - 1 was unlinked */
+  STORE(&oSymTable->epoch, epoch + 1);
+  SymTable_freeRetired(oSymTable, (epoch + 2) % EPOCH_LISTS);
+}
+
+/* Retire node, which has been unlinked from oSymTable, and reclaim
+   retired memory now and then. */
+static void SymTable_retireNode(SymTable_T oSymTable, struct SymTable_Node *node)
+{
+  size_t list;
+
+  pthread_mutex_lock(&oSymTable->reclaimLock);
+
+  list = oSymTable->epoch % EPOCH_LISTS;
+  node->retired = oSymTable->retiredNodes[list];
+  oSymTable->retiredNodes[list] = node;
+
+  oSymTable->retiredCount++;
+  if (oSymTable->retiredCount >= RECLAIM_THRESHOLD)
+  {
+    oSymTable->retiredCount = 0;
+    SymTable_reclaim(oSymTable);
+  }
+
+  pthread_mutex_unlock(&oSymTable->reclaimLock);
+}
+
+/* Retire buckets, which oSymTable no longer uses, with every node on
+   its chains, and free them at once unless a lookup may read them. */
+static void SymTable_retireBuckets(SymTable_T oSymTable,
+                                   struct SymTable_Buckets *buckets)
+{
+  struct SymTable_Node *current;
+  struct SymTable_Node *next;
+  size_t list;
+  size_t i;
+
+  pthread_mutex_lock(&oSymTable->reclaimLock);
+
+  list = oSymTable->epoch % EPOCH_LISTS;
+  buckets->retired = oSymTable->retiredBuckets[list];
+  oSymTable->retiredBuckets[list] = buckets;
+
+  for (i = 0; i < buckets->count; i++)
+  {
+    for (current = buckets->heads[i]; current != NULL; current = next)
+    {
+      next = current->next;
+      current->retired = oSymTable->retiredNodes[list];
+      oSymTable->retiredNodes[list] = current;
+    }
+  }
+
+  /* memory retired in an epoch is freed once the epoch has advanced
+     twice, which takes no time when no lookup is in progress */
+  for (i = 1; i < EPOCH_LISTS; i++)
+  {
+    SymTable_reclaim(oSymTable);
+  }
+
+  pthread_mutex_unlock(&oSymTable->reclaimLock);
+}
+
+/* Add iDelta to the length of stripe, whose lock the caller holds for
+   writing. */
+static void SymTable_addLength(struct SymTable_Stripe *stripe, int iDelta)
+{
+  __atomic_store_n(&stripe->length, stripe->length + (size_t)iDelta,
+                   __ATOMIC_RELAXED);
+}
+
+/* Acquire every stripe lock of oSymTable, for writing if iWrite or for
+   reading otherwise. Stripes are always locked in ascending order, so
+   two threads locking them all cannot deadlock. */
+static void SymTable_lockAll(SymTable_T oSymTable, int iWrite)
+{
+  size_t i;
+
+  for (i = 0; i < NUM_STRIPES; i++)
+  {
+    if (iWrite)
+    {
+      pthread_rwlock_wrlock(&oSymTable->stripes[i].lock);
+    }
+    else
+    {
+      pthread_rwlock_rdlock(&oSymTable->stripes[i].lock);
+    }
+  }
+}
+
+/* Release every stripe lock of oSymTable. */
+static void SymTable_unlockAll(SymTable_T oSymTable)
+{
+  size_t i;
+
+  for (i = NUM_STRIPES; i > 0; i--)
+  {
+    pthread_rwlock_unlock(&oSymTable->stripes[i - 1].lock);
+  }
+}
+
+/* Free the nodes on the chains of buckets, and buckets itself, which
+   no lookup has seen. */
+static void SymTable_freeBuckets(struct SymTable_Buckets *buckets)
+{
+  struct SymTable_Node *current;
+  struct SymTable_Node *next;
+  size_t i;
+
+  for (i = 0; i < buckets->count; i++)
+  {
+    for (current = buckets->heads[i]; current != NULL; current = next)
+    {
+      next = current->next;
+      free(current);
+    }
+  }
+  free(buckets);
+}
+
+/* SymTable_expand takes a SymTable_T type oSymTable and doubles its
+number of buckets, unless another thread has already expanded it past
+uOldNumOfBuckets. It stops every writer to oSymTable while it copies
+the bindings into new chains, but lookups continue on the old chains,
+which stay intact until the new ones replace them all at once. If there
+is insufficient memory, oSymTable keeps its buckets, which is harmless
+since chains merely grow longer. */
+static void SymTable_expand(SymTable_T oSymTable, size_t uOldNumOfBuckets)
+{
+  struct SymTable_Buckets *oldBuckets;
+  struct SymTable_Buckets *newBuckets;
+  struct SymTable_Node *current;
+  struct SymTable_Node *copy;
+  struct SymTable_Node **head;
+  size_t size;
+  size_t i;
+
+  SymTable_lockAll(oSymTable, 1);
+
+  oldBuckets = oSymTable->buckets;
+  if (oldBuckets->count != uOldNumOfBuckets
+      || uOldNumOfBuckets > SIZE_MAX / 2)
+  {
+    SymTable_unlockAll(oSymTable);
+    return;
+  }
+
+  newBuckets = SymTable_newBuckets(uOldNumOfBuckets * 2);
+  if (newBuckets == NULL)
+  {
+    SymTable_unlockAll(oSymTable);
+    return;
+  }
+
+  /* each binding stays in its stripe, since only higher bits of the
+     hash are added to the bucket index */
+  for (i = 0; i < uOldNumOfBuckets; i++)
+  {
+    for (current = oldBuckets->heads[i]; current != NULL;
+         current = current->next)
+    {
+      size = sizeof(struct SymTable_Node) + strlen(current->key) + 1;
+      copy = malloc(size);
+      if (copy == NULL)
+      {
+        SymTable_unlockAll(oSymTable);
+        SymTable_freeBuckets(newBuckets);
+        return;
+      }
+      memcpy(copy, current, size);
+      head = SymTable_head(newBuckets, current->hash);
+      copy->next = *head;
+      *head = copy;
+    }
+  }
+
+  /* the release store makes the copies visible to any lookup that
+     reads the new bucket array */
+  STORE(&oSymTable->buckets, newBuckets);
+
+  SymTable_unlockAll(oSymTable);
+
+  SymTable_retireBuckets(oSymTable, oldBuckets);
+}
+
+SymTable_T SymTable_new(void)
+{
+  SymTable_T oSymTable;
+  size_t i;
+
+  oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+  if (oSymTable == NULL)
+  {
+    return NULL;
+  }
+
+  oSymTable->buckets = SymTable_newBuckets(INITIAL_BUCKETS);
+  if (oSymTable->buckets == NULL)
+  {
+    free(oSymTable);
+    return NULL;
+  }
+
+  if (pthread_mutex_init(&oSymTable->reclaimLock, NULL) != 0)
+  {
+    free(oSymTable->buckets);
+    free(oSymTable);
+    return NULL;
+  }
+
+  for (i = 0; i < NUM_STRIPES; i++)
+  {
+    if (pthread_rwlock_init(&oSymTable->stripes[i].lock, NULL) != 0)
+    {
+      while (i > 0)
+      {
+        i--;
+        pthread_rwlock_destroy(&oSymTable->stripes[i].lock);
+      }
+      pthread_mutex_destroy(&oSymTable->reclaimLock);
+      free(oSymTable->buckets);
+      free(oSymTable);
+      return NULL;
+    }
+    oSymTable->stripes[i].length = 0;
+  }
+
+  oSymTable->epoch = 0;
+  oSymTable->retiredCount = 0;
+  for (i = 0; i < EPOCH_LISTS; i++)
+  {
+    oSymTable->retiredNodes[i] = NULL;
+    oSymTable->retiredBuckets[i] = NULL;
+  }
+
+  return oSymTable;
+}
+
+void SymTable_free(SymTable_T oSymTable)
+{
+  struct SymTable_Node *current;
+  struct SymTable_Node *next;
+  size_t i;
+
+  assert(oSymTable != NULL);
+
+  for (i = 0; i < oSymTable->buckets->count; i++)
+  {
+    for (current = oSymTable->buckets->heads[i]; current != NULL;
+         current = next)
+    {
+      next = current->next;
+      free(current);
+    }
+  }
+
+  for (i = 0; i < EPOCH_LISTS; i++)
+  {
+    SymTable_freeRetired(oSymTable, i);
+  }
+
+  for (i = 0; i < NUM_STRIPES; i++)
+  {
+    pthread_rwlock_destroy(&oSymTable->stripes[i].lock);
+  }
+  pthread_mutex_destroy(&oSymTable->reclaimLock);
+
+  free(oSymTable->buckets);
+  free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+  size_t length = 0;
+  size_t i;
+
+  assert(oSymTable != NULL);
+
+  /* bindings put or removed while the stripes are summed may or may
+     not be counted */
+  for (i = 0; i < NUM_STRIPES; i++)
+  {
+    length += __atomic_load_n(&oSymTable->stripes[i].length,
+                              __ATOMIC_RELAXED);
+  }
+
+  return length;
+}
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue)
+{
+  struct SymTable_Node *newNode;
+  struct SymTable_Node **head;
+  struct SymTable_Stripe *stripe;
+  size_t hash;
+  size_t keyLength;
+  size_t numOfBuckets;
+  int expand;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  hash = SymTable_hash(pcKey);
+  keyLength = strlen(pcKey);
+
+  /* allocate before locking, so the stripe is held only briefly */
+  newNode = malloc(sizeof(struct SymTable_Node) + keyLength + 1);
+  if (newNode == NULL)
+  {
+    return 0;
+  }
+  memcpy(newNode->key, pcKey, keyLength + 1);
+  newNode->value = (void*) pvValue;
+  newNode->hash = hash;
+  newNode->retired = NULL;
+
+  stripe = SymTable_stripe(oSymTable, hash);
+  pthread_rwlock_wrlock(&stripe->lock);
+
+  head = SymTable_head(oSymTable->buckets, hash);
+  if (SymTable_search(*head, pcKey, hash) != NULL)
+  {
+    pthread_rwlock_unlock(&stripe->lock);
+    free(newNode);
+    return 0;
+  }
+
+  /* the release store makes the node's contents visible to any lookup
+     that finds it */
+  newNode->next = *head;
+  STORE(head, newNode);
+  SymTable_addLength(stripe, 1);
+
+  /* expansion check: the stripe holds more bindings than buckets */
+  numOfBuckets = oSymTable->buckets->count;
+  expand = stripe->length > numOfBuckets / NUM_STRIPES;
+
+  pthread_rwlock_unlock(&stripe->lock);
+
+  if (expand)
+  {
+    SymTable_expand(oSymTable, numOfBuckets);
+  }
+  return 1;
+}
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue)
+{
+  struct SymTable_Node *found;
+  struct SymTable_Stripe *stripe;
+  void *oldVal = NULL;
+  size_t hash;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  hash = SymTable_hash(pcKey);
+  stripe = SymTable_stripe(oSymTable, hash);
+  pthread_rwlock_wrlock(&stripe->lock);
+
+  found = SymTable_search(*SymTable_head(oSymTable->buckets, hash),
+                          pcKey, hash);
+  if (found != NULL)
+  {
+    oldVal = found->value;
+    STORE(&found->value, (void*) pvValue);
+  }
+
+  pthread_rwlock_unlock(&stripe->lock);
+  return oldVal;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+  struct SymTable_Reader *reader;
+  size_t hash;
+  int found;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  hash = SymTable_hash(pcKey);
+  reader = SymTable_enter(oSymTable, hash);
+  found = SymTable_find(oSymTable, pcKey, hash) != NULL;
+  SymTable_leave(oSymTable, reader, hash);
+  return found;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+  struct SymTable_Node *found;
+  struct SymTable_Reader *reader;
+  void *value = NULL;
+  size_t hash;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  hash = SymTable_hash(pcKey);
+  reader = SymTable_enter(oSymTable, hash);
+  found = SymTable_find(oSymTable, pcKey, hash);
+  if (found != NULL)
+  {
+    value = LOAD(&found->value);
+  }
+  SymTable_leave(oSymTable, reader, hash);
+  return value;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+  struct SymTable_Node *current;
+  struct SymTable_Node **link;
+  struct SymTable_Stripe *stripe;
+  void *holdVal;
+  size_t hash;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  hash = SymTable_hash(pcKey);
+  stripe = SymTable_stripe(oSymTable, hash);
+  pthread_rwlock_wrlock(&stripe->lock);
+
+  /* lookups already past the node keep following its next pointer,
+     which is why the node must outlive the grace period */
+  link = SymTable_head(oSymTable->buckets, hash);
+  for (current = *link; current != NULL; current = *link)
+  {
+    if (current->hash == hash && strcmp(current->key, pcKey) == 0)
+    {
+      STORE(link, current->next);
+      SymTable_addLength(stripe, -1);
+      break;
+    }
+    link = &current->next;
+  }
+
+  pthread_rwlock_unlock(&stripe->lock);
+
+  if (current == NULL)
+  {
+    return NULL;
+  }
+  holdVal = current->value;
+  SymTable_retireNode(oSymTable, current);
+  return holdVal;
+}
+
+void SymTable_map(SymTable_T oSymTable, void(*pfApply)(const char *pcKey, void *pvValue, void *pvExtra), const void *pvExtra)
+{
+  struct SymTable_Node *current;
+  size_t i;
+
+  assert(oSymTable != NULL);
+  assert(pfApply != NULL);
+
+  /* every stripe is held for reading, so pfApply sees one consistent
+     table, and must not itself modify oSymTable */
+  SymTable_lockAll(oSymTable, 0);
+
+  for (i = 0; i < oSymTable->buckets->count; i++)
+  {
+    for (current = oSymTable->buckets->heads[i]; current != NULL;
+         current = current->next)
+    {
+      (*pfApply)(current->key, current->value, (void*)pvExtra);
+    }
+  }
+
+  SymTable_unlockAll(oSymTable);
+}
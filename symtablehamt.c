@@ -0,0 +1,893 @@
+/* This code implements a persistent symbol table using a hash array mapped trie. Each level of the trie consumes BITS bits of a key's hash, and a branch stores only its present children, found through a bitmap. A snapshot is a new table holding one more reference to the same root, so nodes are never changed once another table can see them: an update copies the shared nodes on the path from the root to the binding it changes, and the copies share every other node with the originals. Nodes that only one table reaches, as all of them are while a table has no snapshots, are changed in place. Nodes are freed by reference counting when no table refers to them; the counts are updated with the __atomic builtins of GCC and Clang, so that a snapshot may be used and freed by another thread while the table it was taken from keeps changing. */
+
+#include <assert.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include "symtable.h"
+
+/* Each level of the trie consumes BITS bits of the hash, choosing
+ among FANOUT children. */
+enum {BITS = 6, FANOUT = 64};
+
+/* Number of bits in a hash. Keys whose hashes are equal in all of them
+ share a collision node. */
+#define HASH_BITS (sizeof(size_t) * CHAR_BIT)
+
+/* Kinds of node */
+enum SymTable_Kind {LEAF, BRANCH, COLLISION};
+
+/* Every node begins with a SymTable_Node structure. */
+struct SymTable_Node
+{
+  /* Number of tables and nodes that refer to the node */
+  size_t references;
+  /* One of enum SymTable_Kind */
+  unsigned char kind;
+};
+
+/* Each key-value binding pair is stored in a leaf. */
+struct SymTable_Leaf
+{
+  struct SymTable_Node node;
+  /* Full hash of key */
+  size_t hash;
+  /* Values stored in void pointer. */
+  void *value;
+  /* Key bytes trail the leaf in the same allocation. */
+  char key[];
+};
+
+/* A branch has a child for each set bit of bitmap, in bit order. */
+struct SymTable_Branch
+{
+  struct SymTable_Node node;
+  uint64_t bitmap;
+  struct SymTable_Node *children[];
+};
+
+/* A collision node holds two or more leaves whose keys have the same
+ full hash. */
+struct SymTable_Collision
+{
+  struct SymTable_Node node;
+  /* Hash of every key in leaves */
+  size_t hash;
+  /* Number of leaves */
+  size_t count;
+  struct SymTable_Leaf *leaves[];
+};
+
+/* Begins trie */
+struct SymTable
+{
+  /* Number of bindings is the length */
+  size_t length;
+  /* Root of the trie, or NULL if there are no bindings */
+  struct SymTable_Node *root;
+};
+
+/* Return the hash of pcKey. */
+static size_t SymTable_hash(const char *pcKey)
+{
+  return SymTable_hashWord(pcKey, 0);
+}
+
+/* Return the child index of hash code uHash at the level that
+   consumes the bits from uShift up. */
+static unsigned SymTable_index(size_t uHash, size_t uShift)
+{
+  return (unsigned)(uHash >> uShift) & (FANOUT - 1);
+}
+
+/* Return the number of set bits of uBits. */
+static size_t SymTable_popCount(uint64_t uBits)
+{
+#ifdef __GNUC__
+  return (size_t)__builtin_popcountll(uBits);
+#else
+  size_t count = 0;
+
+  for (; uBits != 0; uBits &= uBits - 1)
+  {
+    count++;
+  }
+  return count;
+#endif
+}
+
+/* Return the position among the children of branch of the child for
+   the bit uBit. */
+static size_t SymTable_position(struct SymTable_Branch *branch, uint64_t uBit)
+{
+  return SymTable_popCount(branch->bitmap & (uBit - 1));
+}
+
+/* Count one more reference to node, and return it. */
+static struct SymTable_Node *SymTable_retain(struct SymTable_Node *node)
+{
+  __atomic_add_fetch(&node->references, 1, __ATOMIC_RELAXED);
+  return node;
+}
+
+/* SymTable_release counts one reference fewer to node. Once none
+remain, it frees node and releases its children. */
+static void SymTable_release(struct SymTable_Node *node)
+{
+  struct SymTable_Branch *branch;
+  struct SymTable_Collision *collision;
+  size_t count;
+  size_t i;
+
+  /* the acquire half orders this thread's frees after every other
+     thread's last use of the node */
+  if (__atomic_sub_fetch(&node->references, 1, __ATOMIC_ACQ_REL) != 0)
+  {
+    return;
+  }
+
+  if (node->kind == BRANCH)
+  {
+    branch = (struct SymTable_Branch*)node;
+    count = SymTable_popCount(branch->bitmap);
+    for (i = 0; i < count; i++)
+    {
+      SymTable_release(branch->children[i]);
+    }
+  }
+  else if (node->kind == COLLISION)
+  {
+    collision = (struct SymTable_Collision*)node;
+    for (i = 0; i < collision->count; i++)
+    {
+      SymTable_release(&collision->leaves[i]->node);
+    }
+  }
+  free(node);
+}
+
+/* Return a new leaf with one reference binding pcKey, whose hash is
+   uHash and which has uLength characters, to pvValue, or NULL if there
+   is insufficient memory. */
+static struct SymTable_Leaf *SymTable_newLeaf(const char *pcKey, size_t uHash, size_t uLength, const void *pvValue)
+{
+  struct SymTable_Leaf *leaf;
+
+  leaf = malloc(sizeof(struct SymTable_Leaf) + uLength + 1);
+  if (leaf == NULL)
+  {
+    return NULL;
+  }
+  leaf->node.references = 1;
+  leaf->node.kind = LEAF;
+  leaf->hash = uHash;
+  leaf->value = (void*) pvValue;
+  memcpy(leaf->key, pcKey, uLength + 1);
+  return leaf;
+}
+
+/* Return a new branch with one reference and room for uCount
+   children, or NULL if there is insufficient memory. */
+static struct SymTable_Branch *SymTable_newBranch(uint64_t uBitmap, size_t uCount)
+{
+  struct SymTable_Branch *branch;
+
+  branch = malloc(sizeof(struct SymTable_Branch)
+                  + uCount * sizeof(struct SymTable_Node*));
+  if (branch == NULL)
+  {
+    return NULL;
+  }
+  branch->node.references = 1;
+  branch->node.kind = BRANCH;
+  branch->bitmap = uBitmap;
+  return branch;
+}
+
+/* Return a new collision node with one reference and room for uCount
+   leaves of hash uHash, or NULL if there is insufficient memory. */
+static struct SymTable_Collision *SymTable_newCollision(size_t uHash, size_t uCount)
+{
+  struct SymTable_Collision *collision;
+
+  collision = malloc(sizeof(struct SymTable_Collision)
+                     + uCount * sizeof(struct SymTable_Leaf*));
+  if (collision == NULL)
+  {
+    return NULL;
+  }
+  collision->node.references = 1;
+  collision->node.kind = COLLISION;
+  collision->hash = uHash;
+  collision->count = uCount;
+  return collision;
+}
+
+/* Return the hash of every key under node, a leaf or collision node. */
+static size_t SymTable_nodeHash(struct SymTable_Node *node)
+{
+  if (node->kind == LEAF)
+  {
+    return ((struct SymTable_Leaf*)node)->hash;
+  }
+  return ((struct SymTable_Collision*)node)->hash;
+}
+
+/* SymTable_pair returns a new subtree holding old, a leaf or collision
+node, and leaf, whose hash differs from the hash of old's keys, at the
+level that consumes the hash bits from uShift up. The subtree takes a
+new reference to old and takes over the reference to leaf. If there is
+insufficient memory, it releases leaf and returns NULL. */
+static struct SymTable_Node *SymTable_pair(struct SymTable_Node *old, struct SymTable_Leaf *leaf, size_t uShift)
+{
+  struct SymTable_Branch *branch;
+  struct SymTable_Node *child;
+  unsigned oldIndex = SymTable_index(SymTable_nodeHash(old), uShift);
+  unsigned newIndex = SymTable_index(leaf->hash, uShift);
+
+  assert(uShift < HASH_BITS);
+  if (oldIndex == newIndex)
+  {
+    /* the hashes agree here, so the two part at a deeper level */
+    child = SymTable_pair(old, leaf, uShift + BITS);
+    if (child == NULL)
+    {
+      return NULL;
+    }
+    branch = SymTable_newBranch((uint64_t)1 << oldIndex, 1);
+    if (branch == NULL)
+    {
+      SymTable_release(child);
+      return NULL;
+    }
+    branch->children[0] = child;
+    return &branch->node;
+  }
+
+  branch = SymTable_newBranch(((uint64_t)1 << oldIndex)
+                              | ((uint64_t)1 << newIndex), 2);
+  if (branch == NULL)
+  {
+    SymTable_release(&leaf->node);
+    return NULL;
+  }
+  branch->children[oldIndex < newIndex ? 0 : 1] = SymTable_retain(old);
+  branch->children[oldIndex < newIndex ? 1 : 0] = &leaf->node;
+  return &branch->node;
+}
+
+/* Return 1 if a table or node other than the one the caller reached
+   node through refers to node, otherwise 0. A node that is not shared
+   may be changed in place. */
+static int SymTable_shared(struct SymTable_Node *node)
+{
+  /* the acquire load orders the change after the last use of the node
+     by a thread that has since released it */
+  return __atomic_load_n(&node->references, __ATOMIC_ACQUIRE) != 1;
+}
+
+/* Return a copy of branch, with room for uCount children, that takes
+   new references to the children of branch, or NULL if there is
+   insufficient memory. */
+static struct SymTable_Branch *SymTable_copyBranch(struct SymTable_Branch *branch, size_t uCount)
+{
+  struct SymTable_Branch *copy;
+  size_t count = SymTable_popCount(branch->bitmap);
+  size_t i;
+
+  copy = SymTable_newBranch(branch->bitmap, uCount);
+  if (copy == NULL)
+  {
+    return NULL;
+  }
+  for (i = 0; i < count; i++)
+  {
+    copy->children[i] = SymTable_retain(branch->children[i]);
+  }
+  return copy;
+}
+
+/* Return a copy of collision, with room for uCount leaves, that takes
+   new references to the leaves of collision, or NULL if there is
+   insufficient memory. */
+static struct SymTable_Collision *SymTable_copyCollision(struct SymTable_Collision *collision, size_t uCount)
+{
+  struct SymTable_Collision *copy;
+  size_t i;
+
+  copy = SymTable_newCollision(collision->hash, uCount);
+  if (copy == NULL)
+  {
+    return NULL;
+  }
+  copy->count = collision->count;
+  for (i = 0; i < collision->count; i++)
+  {
+    copy->leaves[i] =
+      (struct SymTable_Leaf*)SymTable_retain(&collision->leaves[i]->node);
+  }
+  return copy;
+}
+
+/* SymTable_insert returns the subtree that replaces node, at the level
+that consumes the hash bits from uShift up, once leaf is added to it or
+put in place of the leaf with the same key. The result takes over the
+caller's references to node and to leaf. Nodes on the path to leaf
+that are not shared are changed in place; shared ones are copied, and
+the copies share every node off the path with the originals. If there
+is insufficient memory, it releases leaf and returns NULL, and node is
+unchanged. */
+static struct SymTable_Node *SymTable_insert(struct SymTable_Node *node, struct SymTable_Leaf *leaf, size_t uShift)
+{
+  struct SymTable_Branch *branch;
+  struct SymTable_Collision *collision;
+  struct SymTable_Leaf *old;
+  struct SymTable_Node *child;
+  struct SymTable_Node *result;
+  uint64_t bit;
+  size_t position;
+  size_t count;
+  int shared = SymTable_shared(node);
+
+  if (node->kind == LEAF)
+  {
+    old = (struct SymTable_Leaf*)node;
+    if (old->hash == leaf->hash && strcmp(old->key, leaf->key) == 0)
+    {
+      SymTable_release(node);
+      return &leaf->node;
+    }
+    if (old->hash != leaf->hash)
+    {
+      result = SymTable_pair(node, leaf, uShift);
+    }
+    else
+    {
+      collision = SymTable_newCollision(leaf->hash, 2);
+      if (collision == NULL)
+      {
+        SymTable_release(&leaf->node);
+        return NULL;
+      }
+      collision->leaves[0] = (struct SymTable_Leaf*)SymTable_retain(node);
+      collision->leaves[1] = leaf;
+      result = &collision->node;
+    }
+    if (result != NULL)
+    {
+      SymTable_release(node);
+    }
+    return result;
+  }
+
+  if (node->kind == COLLISION)
+  {
+    collision = (struct SymTable_Collision*)node;
+    if (collision->hash != leaf->hash)
+    {
+      result = SymTable_pair(node, leaf, uShift);
+      if (result != NULL)
+      {
+        SymTable_release(node);
+      }
+      return result;
+    }
+    for (position = 0; position < collision->count; position++)
+    {
+      if (strcmp(collision->leaves[position]->key, leaf->key) == 0)
+      {
+        break;
+      }
+    }
+    count = collision->count + (position == collision->count);
+    if (shared)
+    {
+      collision = SymTable_copyCollision(collision, count);
+    }
+    else if (count > collision->count)
+    {
+      collision = realloc(collision, sizeof(struct SymTable_Collision)
+                          + count * sizeof(struct SymTable_Leaf*));
+    }
+    if (collision == NULL)
+    {
+      SymTable_release(&leaf->node);
+      return NULL;
+    }
+    if (position < collision->count)
+    {
+      SymTable_release(&collision->leaves[position]->node);
+    }
+    collision->leaves[position] = leaf;
+    collision->count = count;
+    if (shared)
+    {
+      SymTable_release(node);
+    }
+    return &collision->node;
+  }
+
+  branch = (struct SymTable_Branch*)node;
+  bit = (uint64_t)1 << SymTable_index(leaf->hash, uShift);
+  position = SymTable_position(branch, bit);
+  count = SymTable_popCount(branch->bitmap);
+
+  if ((branch->bitmap & bit) == 0)
+  {
+    if (shared)
+    {
+      branch = SymTable_copyBranch(branch, count + 1);
+    }
+    else
+    {
+      branch = realloc(branch, sizeof(struct SymTable_Branch)
+                       + (count + 1) * sizeof(struct SymTable_Node*));
+    }
+    if (branch == NULL)
+    {
+      SymTable_release(&leaf->node);
+      return NULL;
+    }
+    memmove(&branch->children[position + 1], &branch->children[position],
+            (count - position) * sizeof(struct SymTable_Node*));
+    branch->children[position] = &leaf->node;
+    branch->bitmap |= bit;
+    if (shared)
+    {
+      SymTable_release(node);
+    }
+    return &branch->node;
+  }
+
+  /* a copy's new reference to the child makes the child shared, so
+     the recursion copies it in turn */
+  if (shared)
+  {
+    branch = SymTable_copyBranch(branch, count);
+    if (branch == NULL)
+    {
+      SymTable_release(&leaf->node);
+      return NULL;
+    }
+  }
+  child = SymTable_insert(branch->children[position], leaf, uShift + BITS);
+  if (child == NULL)
+  {
+    if (shared)
+    {
+      SymTable_release(&branch->node);
+    }
+    return NULL;
+  }
+  branch->children[position] = child;
+  if (shared)
+  {
+    SymTable_release(node);
+  }
+  return &branch->node;
+}
+
+/* SymTable_delete sets *ppsResult to the subtree that replaces node,
+at the level that consumes the hash bits from uShift up, once the leaf
+whose key is pcKey, which hashes to uHash and must be in the subtree,
+is removed from it. The result is NULL if the subtree would be empty,
+and otherwise takes over the caller's reference to node. As with
+SymTable_insert, nodes on the path that are not shared are changed in
+place and shared ones are copied. SymTable_delete returns 0 if there is
+insufficient memory, leaving node unchanged, and otherwise 1. */
+static int SymTable_delete(struct SymTable_Node *node, const char *pcKey, size_t uHash, size_t uShift, struct SymTable_Node **ppsResult)
+{
+  struct SymTable_Branch *branch;
+  struct SymTable_Collision *collision;
+  struct SymTable_Node *child;
+  uint64_t bit;
+  size_t position;
+  size_t count;
+  int shared = SymTable_shared(node);
+
+  if (node->kind == LEAF)
+  {
+    SymTable_release(node);
+    *ppsResult = NULL;
+    return 1;
+  }
+
+  if (node->kind == COLLISION)
+  {
+    collision = (struct SymTable_Collision*)node;
+    for (position = 0;
+         strcmp(collision->leaves[position]->key, pcKey) != 0;
+         position++)
+    {
+    }
+    /* a single remaining leaf needs no collision node */
+    if (collision->count == 2)
+    {
+      *ppsResult = SymTable_retain(&collision->leaves[1 - position]->node);
+      SymTable_release(node);
+      return 1;
+    }
+    if (shared)
+    {
+      collision = SymTable_copyCollision(collision, collision->count);
+      if (collision == NULL)
+      {
+        return 0;
+      }
+    }
+    SymTable_release(&collision->leaves[position]->node);
+    collision->count--;
+    memmove(&collision->leaves[position], &collision->leaves[position + 1],
+            (collision->count - position) * sizeof(struct SymTable_Leaf*));
+    if (shared)
+    {
+      SymTable_release(node);
+    }
+    *ppsResult = &collision->node;
+    return 1;
+  }
+
+  branch = (struct SymTable_Branch*)node;
+  bit = (uint64_t)1 << SymTable_index(uHash, uShift);
+  position = SymTable_position(branch, bit);
+  count = SymTable_popCount(branch->bitmap);
+
+  if (shared)
+  {
+    branch = SymTable_copyBranch(branch, count);
+    if (branch == NULL)
+    {
+      return 0;
+    }
+  }
+  if (! SymTable_delete(branch->children[position], pcKey, uHash,
+                        uShift + BITS, &child))
+  {
+    if (shared)
+    {
+      SymTable_release(&branch->node);
+    }
+    return 0;
+  }
+  if (shared)
+  {
+    SymTable_release(node);
+  }
+
+  if (child != NULL)
+  {
+    branch->children[position] = child;
+  }
+  else
+  {
+    count--;
+    memmove(&branch->children[position], &branch->children[position + 1],
+            (count - position) * sizeof(struct SymTable_Node*));
+    branch->bitmap &= ~bit;
+  }
+
+  /* a branch left with a single leaf or collision node is replaced by
+     it, since lookups check the whole hash and key there anyway */
+  if (count == 0)
+  {
+    SymTable_release(&branch->node);
+    *ppsResult = NULL;
+  }
+  else if (count == 1 && branch->children[0]->kind != BRANCH)
+  {
+    *ppsResult = SymTable_retain(branch->children[0]);
+    SymTable_release(&branch->node);
+  }
+  else
+  {
+    *ppsResult = &branch->node;
+  }
+  return 1;
+}
+
+/* SymTable_find returns the leaf of oSymTable whose key is pcKey,
+which hashes to uHash, or NULL if there is no such leaf. If pbShared is
+not NULL, it sets *pbShared to 0 if no other table can reach the leaf
+and to 1 otherwise. */
+static struct SymTable_Leaf *SymTable_find(SymTable_T oSymTable, const char *pcKey, size_t uHash, int *pbShared)
+{
+  struct SymTable_Node *node = oSymTable->root;
+  struct SymTable_Branch *branch;
+  struct SymTable_Collision *collision;
+  struct SymTable_Leaf *leaf;
+  uint64_t bit;
+  size_t shift = 0;
+  size_t i;
+  int shared = 0;
+
+  while (node != NULL)
+  {
+    /* a node that is not shared is reachable only through its parent */
+    if (SymTable_shared(node))
+    {
+      shared = 1;
+    }
+
+    if (node->kind == LEAF)
+    {
+      leaf = (struct SymTable_Leaf*)node;
+      if (leaf->hash != uHash || strcmp(leaf->key, pcKey) != 0)
+      {
+        return NULL;
+      }
+      if (pbShared != NULL)
+      {
+        *pbShared = shared;
+      }
+      return leaf;
+    }
+
+    if (node->kind == COLLISION)
+    {
+      collision = (struct SymTable_Collision*)node;
+      if (collision->hash != uHash)
+      {
+        return NULL;
+      }
+      for (i = 0; i < collision->count; i++)
+      {
+        if (strcmp(collision->leaves[i]->key, pcKey) == 0)
+        {
+          if (pbShared != NULL)
+          {
+            *pbShared = shared
+              || SymTable_shared(&collision->leaves[i]->node);
+          }
+          return collision->leaves[i];
+        }
+      }
+      return NULL;
+    }
+
+    branch = (struct SymTable_Branch*)node;
+    bit = (uint64_t)1 << SymTable_index(uHash, shift);
+    if ((branch->bitmap & bit) == 0)
+    {
+      return NULL;
+    }
+    node = branch->children[SymTable_position(branch, bit)];
+    shift += BITS;
+  }
+  return NULL;
+}
+
+SymTable_T SymTable_new(void)
+{
+  SymTable_T oSymTable;
+
+  oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+  if (oSymTable == NULL)
+  {
+    return NULL;
+  }
+
+  oSymTable->length = 0;
+  oSymTable->root = NULL;
+  return oSymTable;
+}
+
+SymTable_T SymTable_snapshot(SymTable_T oSymTable)
+{
+  SymTable_T oSnapshot;
+
+  assert(oSymTable != NULL);
+
+  oSnapshot = (SymTable_T)malloc(sizeof(struct SymTable));
+  if (oSnapshot == NULL)
+  {
+    return NULL;
+  }
+
+  oSnapshot->length = oSymTable->length;
+  oSnapshot->root = oSymTable->root;
+  if (oSnapshot->root != NULL)
+  {
+    SymTable_retain(oSnapshot->root);
+  }
+  return oSnapshot;
+}
+
+void SymTable_free(SymTable_T oSymTable)
+{
+  assert(oSymTable != NULL);
+
+  /* nodes that a snapshot still shares survive */
+  if (oSymTable->root != NULL)
+  {
+    SymTable_release(oSymTable->root);
+  }
+  free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+  assert(oSymTable != NULL);
+
+  return oSymTable->length;
+}
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue)
+{
+  struct SymTable_Leaf *leaf;
+  struct SymTable_Node *newRoot;
+  size_t hash;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  hash = SymTable_hash(pcKey);
+  if (SymTable_find(oSymTable, pcKey, hash, NULL) != NULL)
+  {
+    return 0;
+  }
+
+  leaf = SymTable_newLeaf(pcKey, hash, strlen(pcKey), pvValue);
+  if (leaf == NULL)
+  {
+    return 0;
+  }
+
+  if (oSymTable->root == NULL)
+  {
+    newRoot = &leaf->node;
+  }
+  else
+  {
+    newRoot = SymTable_insert(oSymTable->root, leaf, 0);
+    if (newRoot == NULL)
+    {
+      return 0;
+    }
+  }
+
+  oSymTable->root = newRoot;
+  oSymTable->length++;
+  return 1;
+}
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue)
+{
+  struct SymTable_Leaf *found;
+  struct SymTable_Leaf *leaf;
+  struct SymTable_Node *newRoot;
+  void *oldVal;
+  size_t hash;
+  int shared;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  hash = SymTable_hash(pcKey);
+  found = SymTable_find(oSymTable, pcKey, hash, &shared);
+  if (found == NULL)
+  {
+    return NULL;
+  }
+
+  oldVal = found->value;
+  if (! shared)
+  {
+    /* no snapshot can see the leaf, so it may change in place */
+    found->value = (void*) pvValue;
+    return oldVal;
+  }
+
+  /* If there is insufficient memory for the copy, the binding keeps
+     its old value and NULL is returned as if it were absent. */
+  leaf = SymTable_newLeaf(pcKey, hash, strlen(pcKey), pvValue);
+  if (leaf == NULL)
+  {
+    return NULL;
+  }
+  newRoot = SymTable_insert(oSymTable->root, leaf, 0);
+  if (newRoot == NULL)
+  {
+    return NULL;
+  }
+  oSymTable->root = newRoot;
+  return oldVal;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  return SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey), NULL) != NULL;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+  struct SymTable_Leaf *found;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  found = SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey), NULL);
+  if (found == NULL)
+  {
+    return NULL;
+  }
+  return found->value;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+  struct SymTable_Leaf *found;
+  struct SymTable_Node *newRoot;
+  void *holdVal;
+  size_t hash;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  hash = SymTable_hash(pcKey);
+  found = SymTable_find(oSymTable, pcKey, hash, NULL);
+  if (found == NULL)
+  {
+    return NULL;
+  }
+
+  /* If there is insufficient memory for the copy, the binding stays
+     and NULL is returned as if it were absent. */
+  holdVal = found->value;
+  if (! SymTable_delete(oSymTable->root, pcKey, hash, 0, &newRoot))
+  {
+    return NULL;
+  }
+  oSymTable->root = newRoot;
+  oSymTable->length--;
+  return holdVal;
+}
+
+/* SymTable_mapNode applies *pfApply to each binding under node,
+passing pvExtra. */
+static void SymTable_mapNode(struct SymTable_Node *node, void(*pfApply)(const char *pcKey, void *pvValue, void *pvExtra), void *pvExtra)
+{
+  struct SymTable_Branch *branch;
+  struct SymTable_Collision *collision;
+  struct SymTable_Leaf *leaf;
+  size_t count;
+  size_t i;
+
+  if (node->kind == LEAF)
+  {
+    leaf = (struct SymTable_Leaf*)node;
+    (*pfApply)(leaf->key, leaf->value, pvExtra);
+  }
+  else if (node->kind == COLLISION)
+  {
+    collision = (struct SymTable_Collision*)node;
+    for (i = 0; i < collision->count; i++)
+    {
+      (*pfApply)(collision->leaves[i]->key, collision->leaves[i]->value,
+                 pvExtra);
+    }
+  }
+  else
+  {
+    branch = (struct SymTable_Branch*)node;
+    count = SymTable_popCount(branch->bitmap);
+    for (i = 0; i < count; i++)
+    {
+      SymTable_mapNode(branch->children[i], pfApply, pvExtra);
+    }
+  }
+}
+
+void SymTable_map(SymTable_T oSymTable, void(*pfApply)(const char *pcKey, void *pvValue, void *pvExtra), const void *pvExtra)
+{
+  assert(oSymTable != NULL);
+  assert(pfApply != NULL);
+
+  if (oSymTable->root != NULL)
+  {
+    SymTable_mapNode(oSymTable->root, pfApply, (void*)pvExtra);
+  }
+}
@@ -1,23 +1,224 @@
-/* This code implements a symbol table using a hash table. The hash table does not expand however it does have commented code for an attempt at an expanding hash table. */
+/* This code implements a symbol table using a hash table. A new table keeps its first few bindings in a small array and allocates its buckets only when that array is full. A scoped table also records, for each binding, its scope and the binding it hides, so that leaving a scope undoes just that scope's bindings. A clone shares the chains of the table it was cloned from, and whichever of them first changes a chain copies it. A table loaded by SymTable_loadMapped has no buckets of its own: it looks keys up in the image that SymTable_save wrote, mapped read-only into memory. A table frozen by SymTable_freeze has no buckets either: a minimal perfect hash sends each of its keys to a slot of its own. The hash table expands through the bucket counts in auBucketCounts as bindings are added, or through powers of two when its hash function is not SymTable_hashPolynomial. Expansion is incremental: the old and new bucket arrays coexist while each operation migrates a few old buckets. */
+
+#define _XOPEN_SOURCE 700
 
 #include <assert.h>
+#include <limits.h>
+#include <pthread.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "symtable.h"
+#include "symtablearena.h"
+#include "symtablepool.h"
+
+/* array holds all sizes of buckets. Each count is the largest prime
+ below a power of two, so the table roughly doubles on every expansion. */
+static const size_t auBucketCounts[] = {509, 1021, 2039, 4093, 8191, 16381, 32749, 65521,
+                                        131071, 262139, 524287, 1048573, 2097143,
+                                        4194301, 8388593, 16777213, 33554393,
+                                        67108859, 134217689, 268435399, 536870909,
+                                        1073741789, 2147483647, 4294967291U};
+
+/* Number of entries in auBucketCounts */
+#define BUCKET_COUNTS_LENGTH (sizeof(auBucketCounts) / sizeof(auBucketCounts[0]))
+
+/* A table with a masked hash function starts with 2 to the power
+ MIN_BUCKET_BITS buckets, the power of two just above auBucketCounts[0]. */
+enum {MIN_BUCKET_BITS = 9};
+
+/* A table holds up to SMALL_CAPACITY bindings in its small array
+ before it allocates any buckets. Most scopes never outgrow it, and
+ scanning a few contiguous hashes costs no more than indexing a bucket. */
+enum {SMALL_CAPACITY = 8};
+
+/* Number of old buckets migrated by each put, replace, contains, get,
+ and remove while an expansion is in progress. Any value of at least
+ one finishes a migration before the next expansion is due. */
+enum {MIGRATE_STEP = 4};
+
+/* Number of keys that SymTable_getMany and SymTable_containsMany hash
+ and prefetch together */
+enum {BATCH_SIZE = 16};
+
+/* SymTable_save starts each saved value at a multiple of IMAGE_ALIGN
+ bytes from the start of the image, which mmap places on a page, so
+ that the values are aligned for any type they may hold. */
+enum {IMAGE_ALIGN = 16};
+
+/* An image begins with acImageMagic, whose last digit is the version
+ of its format, and ends with IMAGE_ALIGN zero bytes, so that every key
+ in it ends before the image does. */
+static const char acImageMagic[8] = "SymTab2";
+
+/* SymTable_save gives up after TEMP_ATTEMPTS names for its temporary
+ file are all taken. */
+enum {TEMP_ATTEMPTS = 16};
+
+/* A value of size_t whose bytes differ, so that a machine with another
+ byte order reads it as something else */
+#define IMAGE_ORDER ((size_t)0x01020304)
+
+/* SymTable_freeze gives each pilot of a frozen table FROZEN_BUCKET_SIZE
+ keys on average. More keys per pilot take less memory but longer to
+ freeze. */
+enum {FROZEN_BUCKET_SIZE = 3};
+
+/* Number of seeds that SymTable_freeze tries before it gives up */
+enum {FREEZE_ATTEMPTS = 8};
+
+/* SymTable_freeze tries at most PILOT_TRIES times as many pilots for a
+ bucket as the table has bindings, plus PILOT_TRIES_MIN, before it moves
+ on to another seed. Even the last bucket, which has a single free slot
+ to hit, finds its pilot within that many tries but for a chance of
+ about e to the minus PILOT_TRIES. */
+enum {PILOT_TRIES = 16, PILOT_TRIES_MIN = 1024};
+
+/* Number of bits in each word of the occupancy bitmap */
+#define WORD_BITS (sizeof(size_t) * CHAR_BIT)
+
+/* Hint that the memory at p will be read soon. */
+#ifdef __GNUC__
+#define PREFETCH(p) __builtin_prefetch(p)
+#else
+#define PREFETCH(p) ((void)(p))
+#endif
 
-/* array holds all sizes of buckets  */
-static const size_t auBucketCounts[] = {509, 1021, 2039, 4093, 8191, 16381, 32749, 65521}; 
+/* One worker of SymTable_mapParallel, and the buckets it visits */
+struct SymTable_MapWorker
+{
+  /* Table being mapped */
+  SymTable_T table;
+  /* The worker visits the buckets that SymTable_mapBuckets numbers from
+     first up to but not including last */
+  size_t first;
+  size_t last;
+  /* Function applied to each binding, and the worker's own extra */
+  void (*apply)(const char *pcKey, void *pvValue, void *pvExtra);
+  void *extra;
+  /* Thread running the worker, if started is 1 */
+  pthread_t thread;
+  int started;
+};
+
+/* An image written by SymTable_save begins with a SymTable_Image
+ structure. Every offset is in bytes from the start of the image. */
+struct SymTable_Image
+{
+  /* acImageMagic */
+  char magic[8];
+  /* sizeof(size_t) and IMAGE_ORDER, as the saving machine wrote them */
+  size_t wordSize;
+  size_t order;
+  /* Number of bindings */
+  size_t length;
+  /* Number of slots, a power of two at least twice length */
+  size_t numOfSlots;
+  /* Seed given to SymTable_hashWord */
+  size_t seed;
+  /* Offset of numOfSlots SymTable_ImageEntry structures. The entry of
+     a key is in the first slot at or after the one its hash selects,
+     wrapping around, that is empty or holds that key. */
+  size_t entries;
+  /* Size of the whole image */
+  size_t size;
+};
+
+/* Each slot of an image holds a SymTable_ImageEntry. */
+struct SymTable_ImageEntry
+{
+  /* Full hash of key */
+  size_t hash;
+  /* Offset of the key, or 0 if the slot is empty. The key's value
+     follows it, so that a lookup reads both from one place. */
+  size_t key;
+  /* Offset of the value's bytes, or 0 if the value is NULL */
+  size_t value;
+};
+
+/* A table frozen by SymTable_freeze keeps its bindings in a
+ SymTable_Frozen structure, in slots chosen by a minimal perfect hash:
+ the hash of a key selects a bucket, and that bucket's pilot, chosen
+ when the table was frozen, sends each of its keys to a slot that no
+ other key uses. So a lookup reads one pilot and one slot, and compares
+ one key. */
+struct SymTable_Frozen
+{
+  /* The binding in slot i has the key at keys + keyOffsets[i] and the
+     value values[i]. Offsets take 32 bits where pointers take 64. */
+  uint32_t *keyOffsets;
+  void **values;
+  /* Pilots of the buckets, and their number */
+  uint32_t *pilots;
+  size_t numOfBuckets;
+  /* Keys of every slot, one after another in slot order */
+  char *keys;
+};
 
 /* Each key-value binding pair is stored in a Binding structure.
  Bindings  are linked with pointers to form a linked list. */
 struct SymTable_Node
 {
-  /* Keys stored in constant char pointer. */
-  const char *key;
   /* Values stored in void pointer. */
   void *value;
+  /* Full hash of key. Chain walks compare it before calling strcmp,
+     and expansion uses it to place the node without rereading key. */
+  size_t hash;
   /* Structure points to next binding in hash table. */
   struct SymTable_Node *next;
+  /* Key bytes trail the node in the same allocation, or, in a table
+     with a pool, a SymTable_Interned structure does. Read them with
+     SymTable_nodeKey. */
+  char key[];
+};
+
+/* In a table with a pool, each node's key bytes are replaced by this
+ structure, which names the key interned in the pool. key[] begins at
+ the end of struct SymTable_Node, whose pointers align it for one. */
+struct SymTable_Interned
+{
+  /* The interned key */
+  const char *key;
+};
+
+/* Each binding of a scoped table is preceded, in the same allocation,
+ by a SymTable_Scope structure. The bindings form a list in the order
+ they were put, so the bindings of the innermost scope are its newest. */
+struct SymTable_Scope
+{
+  /* Depth of the scope the binding was put in, 0 being outermost */
+  size_t depth;
+  /* Binding of the same key in an enclosing scope that this binding
+     hides, or NULL. It is out of every chain until this binding goes. */
+  struct SymTable_Node *shadowed;
+  /* Binding put just before this one, or NULL */
+  struct SymTable_Node *older;
+  /* Binding put just after this one, or NULL */
+  struct SymTable_Node *newer;
+};
+
+/* A binding of a table that has no buckets yet. The hash is kept
+ beside the node so that a scan of the small array reads one
+ contiguous block until a hash matches. */
+struct SymTable_Small
+{
+  /* Full hash of the node's key */
+  size_t hash;
+  /* Node of the binding, allocated with malloc */
+  struct SymTable_Node *node;
+};
+
+/* A table and its clones form a family, which shares one arena. */
+struct SymTable_Family
+{
+  /* Tables of the family, linked through their nextInFamily fields */
+  struct SymTable *first;
 };
 
 /* Begins hash table */
@@ -25,370 +226,2552 @@ struct SymTable
 {
   /* Number of bindings is the length  */
   size_t length;
-  /* struct Binding begins hash table */
+  /* struct Binding begins hash table, or NULL while the bindings
+     fit in small */
   struct SymTable_Node **buckets;
   /* Number of buckets in the Symtable  */
   size_t numOfBuckets;
+  /* Index of numOfBuckets within auBucketCounts, or the number of
+     doublings since the table was created if masked */
+  size_t sizeIndex;
+  /* Function that hashes keys, and the seed it is given */
+  SymTable_HashFunction hashFunction;
+  size_t seed;
+  /* Pool in which keys are interned, or NULL if each node holds its
+     own copy */
+  SymTablePool_T pool;
+  /* 1 if bucket counts are powers of two and buckets are chosen by
+     masking the hash, or 0 if bucket counts are the primes of
+     auBucketCounts and buckets are chosen by modulo */
+  int masked;
+  /* Buckets still being migrated into buckets, or NULL when no
+     expansion is in progress */
+  struct SymTable_Node **oldBuckets;
+  /* Number of buckets in oldBuckets */
+  size_t numOfOldBuckets;
+  /* Old buckets below this index have already been migrated */
+  size_t migrateIndex;
+  /* Arena that holds every SymTable_Node, or NULL without buckets.
+     A table and its clones share one arena. */
+  SymTableArena_T arena;
+  /* Family of tables sharing arena, or NULL if the table shares its
+     arena with no other table */
+  struct SymTable_Family *family;
+  /* Next table of the family */
+  struct SymTable *nextInFamily;
+  /* Occupancy bitmap of buckets: bit i % WORD_BITS of occupied[i /
+     WORD_BITS] is 0 only if buckets[i] is empty, so iteration can skip
+     a word's worth of empty buckets at once */
+  size_t *occupied;
+  /* Sharing bitmap of buckets, laid out as occupied: bit i is 1 if the
+     chain of buckets[i] may also be reachable from another table of the
+     family, so that it must be copied before it changes if another
+     table does still reach it, or NULL if no
+     chain is shared. Chains are shared only while no expansion is in
+     progress. */
+  size_t *shared;
+  /* Bindings of a table without buckets, the first length of them
+     in use */
+  struct SymTable_Small small[SMALL_CAPACITY];
+  /* 1 if the table was created by SymTable_newScoped, so that each of
+     its nodes follows a SymTable_Scope, or 0 otherwise */
+  int scoped;
+  /* Depth of the innermost scope, 0 outside every SymTable_enterScope */
+  size_t depth;
+  /* Binding of a scoped table put most recently, or NULL */
+  struct SymTable_Node *latest;
+  /* Mapped image of a table loaded by SymTable_loadMapped, which holds
+     all its bindings, or NULL. Such a table has no buckets but is not
+     small. */
+  const struct SymTable_Image *image;
+  /* Bindings of a table frozen by SymTable_freeze, or NULL. Such a
+     table, too, has no buckets but is not small. */
+  struct SymTable_Frozen *frozen;
 };
 
-/* Return a hash code for pcKey that is between 0 and uBucketCount-1,
-   inclusive. */
-static size_t SymTable_hash(const char *pcKey, size_t uBucketCount)
+/* Return the full-width hash code of pcKey in oSymTable. Reduce it
+   with SymTable_bucket to find the key's bucket. */
+static size_t SymTable_hash(SymTable_T oSymTable, const char *pcKey)
 {
-   const size_t HASH_MULTIPLIER = 65599;
-   size_t u;
-   size_t uHash = 0;
-
-   assert(pcKey != NULL);
-
-   for (u = 0; pcKey[u] != '\0'; u++)
-      uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+  assert(pcKey != NULL);
 
-   return uHash % uBucketCount;
+  return (*oSymTable->hashFunction)(pcKey, oSymTable->seed);
 }
 
-/* SymTable_expand takes a SymTable_T type oSymTable and doubles its size. 
-SymTable_T SymTable_expand(SymTable_T oSymTable)
+/* Return the index of the bucket for hash code uHash in a bucket
+   array of oSymTable with uNumOfBuckets buckets. */
+static size_t SymTable_bucket(SymTable_T oSymTable, size_t uHash, size_t uNumOfBuckets)
 {
-  SymTable_T newSymTable;
-  size_t doubleNumOfBuckets = oSymTable->numOfBuckets++;
-  struct SymTable_Node **extra_buckets = calloc(doubleNumOfBuckets, sizeof(struct SymTable_Node*));
-  struct SymTable_Node *current;
-  struct SymTable_Node *forward;
-  size_t newIndex;
-  char*  defCopyofKey;
-  size_t i;
-  
-  for (i = 0; i < oSymTable->numOfBuckets; i++)
+  if (oSymTable->masked)
   {
-    current = oSymTable->buckets[i];
-
-    create defensive copy
-    defCopyofKey = (char*)malloc(strlen(current->key) + 1);
-    if (defCopyofKey == NULL)
-    {
-      return 0;
-    }
-    
-    while(current != NULL)
-    {
-      forward = current->next;
-      strcpy(defCopyofKey, current->key);
-      newIndex = SymTable_hash(defCopyofKey, oSymTable->numOfBuckets);
-      current->next = extra_buckets[newIndex];
-      extra_buckets[newIndex] = current;
-    }
+    return uHash & (uNumOfBuckets - 1);
   }
+  return uHash % uNumOfBuckets;
+}
 
-  newSymTable = SymTable_new();
-  newSymTable->buckets = extra_buckets;
-  newSymTable->length = oSymTable->length;
-  newSymTable->numOfBuckets = doubleNumOfBuckets;
-  free((void*) current->key);
-  free(current);
-  free(forward);
-  free(defCopyofKey);
-  free(extra_buckets);
-  SymTable_free(oSymTable);
-  return newSymTable;
+/* Return the size of a node of oSymTable whose key has uLength
+   characters. */
+static size_t SymTable_nodeSize(SymTable_T oSymTable, size_t uLength)
+{
+  if (oSymTable->pool != NULL)
+  {
+    return sizeof(struct SymTable_Node) + sizeof(struct SymTable_Interned);
+  }
+  return sizeof(struct SymTable_Node) + uLength + 1;
 }
 
-*/
+/* Return the SymTable_Scope of node, a node of a scoped table. */
+static struct SymTable_Scope *SymTable_scope(struct SymTable_Node *node)
+{
+  return (struct SymTable_Scope*)((char*)node - sizeof(struct SymTable_Scope));
+}
 
-SymTable_T SymTable_new(void)
+/* Return a node from the arena of oSymTable for a key of uLength
+   characters, after a SymTable_Scope if oSymTable is scoped, or NULL
+   if there is insufficient memory. */
+static struct SymTable_Node *SymTable_allocNode(SymTable_T oSymTable, size_t uLength)
 {
-  SymTable_T oSymTable;
-  size_t i;
-  
-  oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
-  if (oSymTable == NULL)
+  char *block;
+
+  if (! oSymTable->scoped)
   {
-    return NULL;
+    return SymTableArena_alloc(oSymTable->arena,
+                               SymTable_nodeSize(oSymTable, uLength));
   }
-
-  oSymTable->length = 0;
-  oSymTable->numOfBuckets = auBucketCounts[0];
-  oSymTable->buckets = calloc(oSymTable->numOfBuckets, sizeof(struct SymTable_Node*));
-  if (oSymTable->buckets == NULL)
+  block = SymTableArena_alloc(oSymTable->arena, sizeof(struct SymTable_Scope)
+                              + SymTable_nodeSize(oSymTable, uLength));
+  if (block == NULL)
   {
-    free(oSymTable);
     return NULL;
   }
+  return (struct SymTable_Node*)(block + sizeof(struct SymTable_Scope));
+}
 
-  for (i = 0; i < oSymTable->numOfBuckets; i++)
+/* Return node, which SymTable_allocNode(oSymTable, uLength) returned,
+   to the arena of oSymTable. */
+static void SymTable_releaseNode(SymTable_T oSymTable, struct SymTable_Node *node, size_t uLength)
+{
+  if (! oSymTable->scoped)
   {
-    oSymTable->buckets[i] = NULL;
+    SymTableArena_release(oSymTable->arena, node,
+                          SymTable_nodeSize(oSymTable, uLength));
+    return;
   }
+  SymTableArena_release(oSymTable->arena, SymTable_scope(node),
+                        sizeof(struct SymTable_Scope)
+                        + SymTable_nodeSize(oSymTable, uLength));
+}
 
-  return oSymTable;
+/* Return the SymTable_Interned structure of node, a node of a table
+   with a pool. */
+static struct SymTable_Interned *SymTable_interned(struct SymTable_Node *node)
+{
+  return (struct SymTable_Interned*)(void*)node->key;
 }
 
-void SymTable_free(SymTable_T oSymTable)
+/* Return the key of node, a node of oSymTable. */
+static const char *SymTable_nodeKey(SymTable_T oSymTable, struct SymTable_Node *node)
 {
-  struct SymTable_Node *current;
-  struct SymTable_Node *forward;
-  size_t i;
+  if (oSymTable->pool == NULL)
+  {
+    return node->key;
+  }
+  return SymTable_interned(node)->key;
+}
 
-  assert(oSymTable != NULL);
+/* Make pcKey, whose SymTable_Key is oKey, the key of node, a new node
+   of oSymTable. Return 0 if there is insufficient memory to intern it,
+   otherwise 1. */
+static int SymTable_setNodeKey(SymTable_T oSymTable, struct SymTable_Node *node, const char *pcKey, SymTable_Key oKey)
+{
+  const char *pcInterned;
 
-  for (i = 0; i < oSymTable->numOfBuckets; i++)
+  if (oSymTable->pool == NULL)
   {
-    current = oSymTable->buckets[i];
-    while (current != NULL)
-    {
-      forward = current->next;
-      free((void*) current->key);
-      free(current);
-      current = forward;
-    }
+    memcpy(node->key, pcKey, oKey.length + 1);
+    return 1;
+  }
+  pcInterned = SymTablePool_internHashed(oSymTable->pool, pcKey, oKey);
+  if (pcInterned == NULL)
+  {
+    return 0;
   }
+  SymTable_interned(node)->key = pcInterned;
+  return 1;
+}
 
-  free(oSymTable->buckets);
-  free(oSymTable);
+/* Return 1 if the key of node, a node of oSymTable, is pcKey, given
+   that pcKey hashes to uHash, or 0 otherwise. */
+static int SymTable_matches(SymTable_T oSymTable, struct SymTable_Node *node, const char *pcKey, size_t uHash)
+{
+  const char *key;
+
+  if (node->hash != uHash)
+  {
+    return 0;
+  }
+  /* a key interned in the table's pool is found by its address */
+  key = SymTable_nodeKey(oSymTable, node);
+  return key == pcKey || strcmp(key, pcKey) == 0;
 }
 
-size_t SymTable_getLength(SymTable_T oSymTable)
+/* Return a new occupancy bitmap for uNumOfBuckets empty buckets, or
+   NULL if there is insufficient memory. */
+static size_t *SymTable_newBitmap(size_t uNumOfBuckets)
 {
-  assert(oSymTable != NULL);
-  
-  return oSymTable->length;
+  return calloc((uNumOfBuckets + WORD_BITS - 1) / WORD_BITS, sizeof(size_t));
 }
 
-int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue)
+/* Mark bucket uIndex of oSymTable as possibly nonempty. */
+static void SymTable_setOccupied(SymTable_T oSymTable, size_t uIndex)
 {
-  struct SymTable_Node *current;
-  struct SymTable_Node *forward;
-  struct SymTable_Node *newNode;
-  char *defCopyofKey;
-  size_t index;
+  oSymTable->occupied[uIndex / WORD_BITS] |= (size_t)1 << (uIndex % WORD_BITS);
+}
 
-  assert(oSymTable != NULL);
-  assert(pcKey != NULL);
+/* Return the index of the lowest set bit of uBits, which is not 0. */
+static size_t SymTable_lowestBit(size_t uBits)
+{
+#ifdef __GNUC__
+  return (size_t)__builtin_ctzll((unsigned long long)uBits);
+#else
+  size_t i = 0;
 
-  /* allocate memory for newNode structure */
-  newNode = malloc(sizeof(struct SymTable_Node));
-  if (newNode == NULL)
+  while ((uBits & 1) == 0)
   {
-    return 0;
+    uBits >>= 1;
+    i++;
   }
+  return i;
+#endif
+}
+
+/* Return 1 if a table of the family of oSymTable other than oSymTable
+   itself still reaches the chain in bucket uIndex of oSymTable, which
+   is marked shared, or 0 otherwise. A shared chain never changes or
+   moves, so any table that reaches it has it in the same bucket of a
+   bucket array of the same size. */
+static int SymTable_chainReferenced(SymTable_T oSymTable, size_t uIndex)
+{
+  struct SymTable *other;
 
-  /* create defensive copy */
-  defCopyofKey = (char*)malloc(strlen(pcKey) + 1);
-  if (defCopyofKey == NULL)
+  /* a clone that failed may leave a sharing bitmap but no family */
+  if (oSymTable->family == NULL)
   {
-    free(newNode);
     return 0;
   }
-  strcpy(defCopyofKey, pcKey);
- 
-  index = SymTable_hash(defCopyofKey, oSymTable->numOfBuckets);
-
-  /* expansion check 
-  if (oSymTable->numOfBuckets < index)
+  for (other = oSymTable->family->first;
+       other != NULL;
+       other = other->nextInFamily)
   {
-    if (index > 65521)
+    /* a table without a sharing bitmap has copied every chain */
+    if (other != oSymTable && other->shared != NULL
+        && other->numOfBuckets == oSymTable->numOfBuckets
+        && other->buckets[uIndex] == oSymTable->buckets[uIndex])
     {
-      return 0;
-    }	
-    oSymTable = SymTable_expand(oSymTable);
-  } */
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* SymTable_unshare gives oSymTable its own copy of the chain of its
+bucket uIndex, which must be marked shared, so that the chain can change
+without affecting the other tables that share it. The copies keep the
+order of the chain. If no other table still reaches the chain, it
+becomes oSymTable's own without copying, so that no node is left behind
+that no table reaches. It returns 1, or 0 if there is insufficient
+memory, in which case oSymTable is left unchanged. */
+static int SymTable_unshare(SymTable_T oSymTable, size_t uIndex)
+{
+  struct SymTable_Node *first = NULL;
+  struct SymTable_Node **last = &first;
+  struct SymTable_Node *current;
+  struct SymTable_Node *copy;
+  struct SymTable_Node *forward;
+  size_t length;
+
+  assert(oSymTable->shared != NULL);
+  assert(oSymTable->oldBuckets == NULL);
+
+  if (! SymTable_chainReferenced(oSymTable, uIndex))
+  {
+    oSymTable->shared[uIndex / WORD_BITS]
+      &= ~((size_t)1 << (uIndex % WORD_BITS));
+    return 1;
+  }
 
-  current = oSymTable->buckets[index];
-  while (current != NULL)
+  for (current = oSymTable->buckets[uIndex];
+       current != NULL;
+       current = current->next)
   {
-    if(strcmp(current->key, defCopyofKey) == 0)
+    length = strlen(current->key);
+    copy = SymTable_allocNode(oSymTable, length);
+    if (copy == NULL)
     {
-      free(defCopyofKey);
-      free(newNode);
+      /* the other tables still use the originals */
+      *last = NULL;
+      for (current = first; current != NULL; current = forward)
+      {
+        forward = current->next;
+        SymTable_releaseNode(oSymTable, current, strlen(current->key));
+      }
       return 0;
     }
-    forward = current->next;
-    current = forward;
+    memcpy(copy, current, SymTable_nodeSize(oSymTable, length));
+    *last = copy;
+    last = &copy->next;
   }
-  
-  newNode->key = defCopyofKey;
-  newNode->value = (void*) pvValue;
-  newNode->next = oSymTable->buckets[index];
-  oSymTable->buckets[index] = newNode;
-  oSymTable->length++;
+  *last = NULL;
+
+  oSymTable->buckets[uIndex] = first;
+  oSymTable->shared[uIndex / WORD_BITS] &= ~((size_t)1 << (uIndex % WORD_BITS));
   return 1;
-  
 }
 
-void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue)
+/* SymTable_own makes sure that the chain holding the bindings of
+oSymTable whose keys hash to uHash is its own, copying it if it is
+shared. It returns 1, or 0 if there is insufficient memory. */
+static int SymTable_own(SymTable_T oSymTable, size_t uHash)
 {
-  struct SymTable_Node *current;
-  struct SymTable_Node *forward;
-  void *oldVal;
-  char *defCopyofKey;
   size_t index;
-  
-  assert(oSymTable != NULL);
-  assert(pcKey != NULL);
 
-  /* create defensive copy */
-  defCopyofKey = malloc(strlen(pcKey) + 1);
-  if (defCopyofKey == NULL)
+  if (oSymTable->shared == NULL)
   {
-    return 0;
+    return 1;
+  }
+  index = SymTable_bucket(oSymTable, uHash, oSymTable->numOfBuckets);
+  if ((oSymTable->shared[index / WORD_BITS]
+       & ((size_t)1 << (index % WORD_BITS))) == 0)
+  {
+    return 1;
   }
-  strcpy(defCopyofKey, pcKey);
+  return SymTable_unshare(oSymTable, index);
+}
+
+/* SymTable_ownAll copies every shared chain of oSymTable, and then
+frees its sharing bitmap. It returns 1, or 0 if there is insufficient
+memory, in which case the chains not yet copied stay shared. */
+static int SymTable_ownAll(SymTable_T oSymTable)
+{
+  size_t numOfWords = (oSymTable->numOfBuckets + WORD_BITS - 1) / WORD_BITS;
+  size_t word;
+  size_t bits;
 
-  index = SymTable_hash(defCopyofKey, oSymTable->numOfBuckets);
-  current = oSymTable->buckets[index];
-  while (current != NULL)
+  for (word = 0; word < numOfWords; word++)
   {
-    if(strcmp(current->key, defCopyofKey) == 0)
+    for (bits = oSymTable->shared[word]; bits != 0; bits &= bits - 1)
     {
-      free(defCopyofKey);
-      oldVal = current->value;
-      current->value = (void*) pvValue;
-      return oldVal;
+      if (! SymTable_unshare(oSymTable,
+                             word * WORD_BITS + SymTable_lowestBit(bits)))
+      {
+        return 0;
+      }
     }
-    forward = current->next;
-    current = forward;
   }
-
-  free(defCopyofKey);
-  return NULL;
+  free(oSymTable->shared);
+  oSymTable->shared = NULL;
+  return 1;
 }
-    
-int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+
+/* SymTable_migrate moves up to uCount of the remaining old buckets of
+oSymTable into its current buckets, relinking the existing nodes.
+Once the last old bucket is moved, the old bucket array is freed. */
+static void SymTable_migrate(SymTable_T oSymTable, size_t uCount)
 {
   struct SymTable_Node *current;
   struct SymTable_Node *forward;
-  char *defCopyofKey;
-  size_t index;
-  
+  size_t newIndex;
+
   assert(oSymTable != NULL);
-  assert(pcKey != NULL);
 
-  /* create defensive copy */
-  defCopyofKey = malloc(strlen(pcKey) + 1);
-  if (defCopyofKey == NULL)
+  while (oSymTable->oldBuckets != NULL && uCount > 0)
   {
-    return 0;
-  }
-  strcpy(defCopyofKey, pcKey);
+    current = oSymTable->oldBuckets[oSymTable->migrateIndex];
+    while (current != NULL)
+    {
+      forward = current->next;
+      newIndex = SymTable_bucket(oSymTable, current->hash, oSymTable->numOfBuckets);
+      current->next = oSymTable->buckets[newIndex];
+      oSymTable->buckets[newIndex] = current;
+      SymTable_setOccupied(oSymTable, newIndex);
+      current = forward;
+    }
+    oSymTable->oldBuckets[oSymTable->migrateIndex] = NULL;
+    oSymTable->migrateIndex++;
+    uCount--;
 
-  index = SymTable_hash(defCopyofKey, oSymTable->numOfBuckets);
-  current = oSymTable->buckets[index];
-  while (current != NULL)
-  {
-    if(strcmp(current->key, defCopyofKey) == 0)
+    if (oSymTable->migrateIndex == oSymTable->numOfOldBuckets)
     {
-      free(defCopyofKey);
-      return 1;
+      free(oSymTable->oldBuckets);
+      oSymTable->oldBuckets = NULL;
+      oSymTable->numOfOldBuckets = 0;
+      oSymTable->migrateIndex = 0;
     }
-    forward = current->next;
-    current = forward;
   }
-  free(defCopyofKey);
-  return 0;
 }
 
-void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+/* SymTable_expand takes a SymTable_T type oSymTable and starts moving
+its bindings into the next larger bucket count in auBucketCounts. The
+current buckets become the old buckets, which later operations drain
+through SymTable_migrate. If there is insufficient memory, oSymTable
+is left unchanged. */
+static void SymTable_expand(SymTable_T oSymTable)
 {
-  struct SymTable_Node *current;
-  struct SymTable_Node *forward;
-  void *foundVal;
-  size_t index;
-  
+  struct SymTable_Node **newBuckets;
+  size_t *newOccupied;
+  size_t newNumOfBuckets;
+
   assert(oSymTable != NULL);
-  assert(pcKey != NULL);
 
-  index = SymTable_hash(pcKey, oSymTable->numOfBuckets);
-  
-  for(current = oSymTable->buckets[index];
-      current != NULL;
-      current = forward)
+  /* migration relinks nodes, which a shared chain does not allow */
+  if (oSymTable->shared != NULL && ! SymTable_ownAll(oSymTable))
+  {
+    return;
+  }
+
+  if (oSymTable->masked)
   {
-    if(strcmp(current->key, pcKey) == 0)
+    if (MIN_BUCKET_BITS + oSymTable->sizeIndex + 1 >= sizeof(size_t) * CHAR_BIT)
     {
-      foundVal = current->value;
-      return foundVal;
+      return;
     }
-    forward = current->next;
+    newNumOfBuckets = oSymTable->numOfBuckets * 2;
+  }
+  else
+  {
+    if (oSymTable->sizeIndex + 1 >= BUCKET_COUNTS_LENGTH)
+    {
+      return;
+    }
+    newNumOfBuckets = auBucketCounts[oSymTable->sizeIndex + 1];
+  }
+
+  newBuckets = calloc(newNumOfBuckets, sizeof(struct SymTable_Node*));
+  if (newBuckets == NULL)
+  {
+    return;
+  }
+  newOccupied = SymTable_newBitmap(newNumOfBuckets);
+  if (newOccupied == NULL)
+  {
+    free(newBuckets);
+    return;
   }
-  return NULL;
 
+  /* a previous expansion must finish before the next one begins */
+  SymTable_migrate(oSymTable, oSymTable->numOfOldBuckets);
+
+  /* only the current buckets need an occupancy bitmap, since
+     migration sets the bits of the buckets it fills */
+  free(oSymTable->occupied);
+  oSymTable->occupied = newOccupied;
+
+  oSymTable->oldBuckets = oSymTable->buckets;
+  oSymTable->numOfOldBuckets = oSymTable->numOfBuckets;
+  oSymTable->migrateIndex = 0;
+  oSymTable->buckets = newBuckets;
+  oSymTable->numOfBuckets = newNumOfBuckets;
+  oSymTable->sizeIndex++;
 }
 
-void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+/* SymTable_promote gives oSymTable, which has no buckets, its first
+bucket array and its arena, and moves the bindings of its small array
+into them. It returns 1, or 0 if there is insufficient memory, in which
+case oSymTable is left unchanged. */
+static int SymTable_promote(SymTable_T oSymTable)
 {
-  const void *holdVal;
-  struct SymTable_Node *previous;
-  struct SymTable_Node *current;
-  struct SymTable_Node *forward;
+  struct SymTable_Node *copies[SMALL_CAPACITY];
+  struct SymTable_Node **buckets;
+  struct SymTable_Node *node;
+  SymTableArena_T arena;
+  size_t *occupied;
+  size_t size;
   size_t index;
+  size_t i;
 
   assert(oSymTable != NULL);
-  assert(pcKey != NULL);
-
-  index = SymTable_hash(pcKey, oSymTable->numOfBuckets);
-  current = oSymTable->buckets[index];
+  assert(oSymTable->buckets == NULL);
 
-  if(current == NULL)
+  buckets = calloc(oSymTable->numOfBuckets, sizeof(struct SymTable_Node*));
+  if (buckets == NULL)
+  {
+    return 0;
+  }
+  occupied = SymTable_newBitmap(oSymTable->numOfBuckets);
+  if (occupied == NULL)
+  {
+    free(buckets);
+    return 0;
+  }
+  arena = SymTableArena_new();
+  if (arena == NULL)
   {
+    free(occupied);
+    free(buckets);
     return 0;
   }
 
-  /* Base Case: if SymTable_T structure has only one SymTableNode */
-  if(strcmp(current->key, pcKey) == 0)
+  /* copy every node into the arena before freeing any, so that a
+     failed allocation leaves the small array intact */
+  for (i = 0; i < oSymTable->length; i++)
   {
-    holdVal = current->value;
-    forward = current->next;
-    free((void*) current->key);
-    free(current);
-    oSymTable->buckets[index] = forward;
-    oSymTable->length--;
-    return (void*) holdVal;
+    node = oSymTable->small[i].node;
+    size = SymTable_nodeSize(oSymTable,
+                             strlen(SymTable_nodeKey(oSymTable, node)));
+    copies[i] = SymTableArena_alloc(arena, size);
+    if (copies[i] == NULL)
+    {
+      SymTableArena_free(arena);
+      free(occupied);
+      free(buckets);
+      return 0;
+    }
+    memcpy(copies[i], node, size);
   }
 
-  previous = oSymTable->buckets[index];
- 
- /* If a binding in the SymTable_T structure has a key that matches pcKey,
- the SymTableNode is removed from the SymTable strucutre and the binding's value is returned.
- Otherwise, NULL is returned. */
- while (current != NULL)
- {
-   if(strcmp(current->key, pcKey) == 0)
-   {
-     holdVal = current->value;
-     forward = current->next;
-     previous->next = forward;
-     free((void*) current->key);
-     free(current);
-     oSymTable->length--;
-     return (void*) holdVal;
-   }
-   forward = current->next;
-   previous = current;
-   current = forward;
- }
+  oSymTable->buckets = buckets;
+  oSymTable->occupied = occupied;
+  oSymTable->arena = arena;
+  for (i = 0; i < oSymTable->length; i++)
+  {
+    free(oSymTable->small[i].node);
+    index = SymTable_bucket(oSymTable, copies[i]->hash, oSymTable->numOfBuckets);
+    copies[i]->next = buckets[index];
+    buckets[index] = copies[i];
+    SymTable_setOccupied(oSymTable, index);
+  }
+  return 1;
+}
 
- return NULL;
+/* SymTable_findSmall returns the index in the small array of
+oSymTable, which has no buckets, of the binding whose key is pcKey,
+given that pcKey hashes to uHash, or SMALL_CAPACITY if there is no such
+binding. */
+static size_t SymTable_findSmall(SymTable_T oSymTable, const char *pcKey, size_t uHash)
+{
+  size_t i;
 
+  for (i = 0; i < oSymTable->length; i++)
+  {
+    if (oSymTable->small[i].hash == uHash
+        && SymTable_matches(oSymTable, oSymTable->small[i].node, pcKey, uHash))
+    {
+      return i;
+    }
+  }
+  return SMALL_CAPACITY;
 }
 
-void SymTable_map(SymTable_T oSymTable, void(*pfApply)(const char *pcKey, void *pvValue, void *pvExtra), const void *pvExtra)
+/* SymTable_chain returns a pointer to the head of the chain that holds
+the bindings of oSymTable whose keys hash to uHash, which is in the old
+buckets if that bucket has not been migrated yet. */
+static struct SymTable_Node **SymTable_chain(SymTable_T oSymTable, size_t uHash)
 {
- struct SymTable_Node *current;
- struct SymTable_Node *forward;
- size_t i;
- 
- assert(oSymTable != NULL);
- assert(pfApply != NULL);
+  size_t index;
 
- for (i = 0; i < oSymTable->numOfBuckets; i++)
- {
-   current = oSymTable->buckets[i];
-   while (current != NULL)
+  assert(oSymTable != NULL);
+
+  if (oSymTable->oldBuckets != NULL)
+  {
+    index = SymTable_bucket(oSymTable, uHash, oSymTable->numOfOldBuckets);
+    if (index >= oSymTable->migrateIndex)
+    {
+      return &oSymTable->oldBuckets[index];
+    }
+  }
+
+  index = SymTable_bucket(oSymTable, uHash, oSymTable->numOfBuckets);
+  return &oSymTable->buckets[index];
+}
+
+/* SymTable_search returns the node of the chain of oSymTable that
+begins with first whose key is pcKey, given that pcKey hashes to uHash,
+or NULL if there is no such node. */
+static struct SymTable_Node *SymTable_search(SymTable_T oSymTable, struct SymTable_Node *first, const char *pcKey, size_t uHash)
+{
+  struct SymTable_Node *current;
+  struct SymTable_Node *forward;
+
+  for (current = first;
+       current != NULL;
+       current = forward)
+  {
+    if (SymTable_matches(oSymTable, current, pcKey, uHash))
+    {
+      return current;
+    }
+    forward = current->next;
+  }
+  return NULL;
+}
+
+/* SymTable_find returns the node of oSymTable whose key is pcKey,
+given that pcKey hashes to uHash, or NULL if there is no such node. */
+static struct SymTable_Node *SymTable_find(SymTable_T oSymTable, const char *pcKey, size_t uHash)
+{
+  size_t i;
+
+  if (oSymTable->buckets == NULL)
+  {
+    i = SymTable_findSmall(oSymTable, pcKey, uHash);
+    return i == SMALL_CAPACITY ? NULL : oSymTable->small[i].node;
+  }
+  return SymTable_search(oSymTable, *SymTable_chain(oSymTable, uHash), pcKey,
+                         uHash);
+}
+
+/* SymTable_findBatch sets ppsFound[i] to SymTable_find of ppcKeys[i]
+for each i below uCount, which is at most BATCH_SIZE. Every key is
+hashed and its bucket prefetched, then the first node of every chain
+is prefetched, and only then are the chains searched, so the cache
+misses of the whole batch overlap instead of happening one by one. */
+static void SymTable_findBatch(SymTable_T oSymTable, const char *const ppcKeys[], size_t uCount, struct SymTable_Node *ppsFound[])
+{
+  struct SymTable_Node **chains[BATCH_SIZE];
+  size_t hashes[BATCH_SIZE];
+  size_t i;
+
+  assert(uCount <= BATCH_SIZE);
+
+  /* a small array is already in cache, so there is nothing to overlap */
+  if (oSymTable->buckets == NULL)
+  {
+    for (i = 0; i < uCount; i++)
+    {
+      assert(ppcKeys[i] != NULL);
+      ppsFound[i] = SymTable_find(oSymTable, ppcKeys[i],
+                                  SymTable_hash(oSymTable, ppcKeys[i]));
+    }
+    return;
+  }
+
+  for (i = 0; i < uCount; i++)
+  {
+    assert(ppcKeys[i] != NULL);
+    hashes[i] = SymTable_hash(oSymTable, ppcKeys[i]);
+    chains[i] = SymTable_chain(oSymTable, hashes[i]);
+    PREFETCH(chains[i]);
+  }
+
+  for (i = 0; i < uCount; i++)
+  {
+    if (*chains[i] != NULL)
+    {
+      PREFETCH(*chains[i]);
+    }
+  }
+
+  for (i = 0; i < uCount; i++)
+  {
+    ppsFound[i] = SymTable_search(oSymTable, *chains[i], ppcKeys[i],
+                                  hashes[i]);
+  }
+}
+
+/* Return a pointer to the byte at uOffset in the image of oSymTable. */
+static const char *SymTable_imageAt(SymTable_T oSymTable, size_t uOffset)
+{
+  return (const char*)oSymTable->image + uOffset;
+}
+
+/* Return the entries of the image of oSymTable. */
+static const struct SymTable_ImageEntry *SymTable_imageEntries(SymTable_T oSymTable)
+{
+  return (const struct SymTable_ImageEntry*)
+    SymTable_imageAt(oSymTable, oSymTable->image->entries);
+}
+
+/* Return the value of entry, an entry of the image of oSymTable. */
+static void *SymTable_imageValue(SymTable_T oSymTable, const struct SymTable_ImageEntry *entry)
+{
+  if (entry->value == 0)
+  {
+    return NULL;
+  }
+  return (void*)SymTable_imageAt(oSymTable, entry->value);
+}
+
+/* SymTable_findImage returns the entry of the image of oSymTable whose
+key is pcKey, given that pcKey hashes to uHash, or NULL if there is no
+such entry. The probe reads slots in order, so no pointer is followed
+until a hash matches. */
+static const struct SymTable_ImageEntry *SymTable_findImage(SymTable_T oSymTable, const char *pcKey, size_t uHash)
+{
+  const struct SymTable_ImageEntry *entries = SymTable_imageEntries(oSymTable);
+  size_t mask = oSymTable->image->numOfSlots - 1;
+  size_t index = uHash & mask;
+  size_t i;
+
+  /* at most every slot is probed, even in an image with no empty one */
+  for (i = 0; i <= mask && entries[index].key != 0; i++)
+  {
+    if (entries[index].hash == uHash
+        && strcmp(SymTable_imageAt(oSymTable, entries[index].key), pcKey) == 0)
+    {
+      return &entries[index];
+    }
+    index = (index + 1) & mask;
+  }
+  return NULL;
+}
+
+/* Return uBits with its bits mixed, so that inputs that differ in any
+   bit give unrelated results. This is the finalizer of MurmurHash3. */
+static uint64_t SymTable_mix(uint64_t uBits)
+{
+  uBits ^= uBits >> 33;
+  uBits *= 0xff51afd7ed558ccdULL;
+  uBits ^= uBits >> 33;
+  uBits *= 0xc4ceb9fe1a85ec53ULL;
+  uBits ^= uBits >> 33;
+  return uBits;
+}
+
+/* Return a number below uRange, which is not 0, taken from the high
+   bits of uBits. Below 2 to the power 32, a multiplication does what
+   would otherwise take a much slower division. */
+static size_t SymTable_reduce(uint64_t uBits, size_t uRange)
+{
+  if (uRange <= 0xffffffffUL)
+  {
+    return (size_t)(((uBits >> 32) * uRange) >> 32);
+  }
+  return (size_t)(uBits % uRange);
+}
+
+/* Return the bucket, among uNumOfBuckets buckets of a frozen table, of
+   a key that hashes to uHash. */
+static size_t SymTable_frozenBucket(size_t uHash, size_t uNumOfBuckets)
+{
+  return SymTable_reduce(SymTable_mix(uHash), uNumOfBuckets);
+}
+
+/* Return the slot, among uLength slots of a frozen table, of a key that
+   hashes to uHash, given the pilot uPilot of the key's bucket. */
+static size_t SymTable_frozenSlot(size_t uHash, uint32_t uPilot, size_t uLength)
+{
+  return SymTable_reduce(SymTable_mix((uint64_t)uHash ^ SymTable_mix(uPilot)),
+                         uLength);
+}
+
+/* Return 1 if oSymTable is read-only, holding its bindings in the slots
+   of a mapped image or a frozen table, or 0 otherwise. */
+static int SymTable_readOnly(SymTable_T oSymTable)
+{
+  return oSymTable->image != NULL || oSymTable->frozen != NULL;
+}
+
+/* Return the number of slots of oSymTable, which is read-only. */
+static size_t SymTable_numOfSlots(SymTable_T oSymTable)
+{
+  if (oSymTable->image != NULL)
+  {
+    return oSymTable->image->numOfSlots;
+  }
+  return oSymTable->length;
+}
+
+/* Return the key in slot uSlot of oSymTable, which is read-only, or
+   NULL if the slot is empty. */
+static const char *SymTable_slotKey(SymTable_T oSymTable, size_t uSlot)
+{
+  const struct SymTable_ImageEntry *entry;
+
+  if (oSymTable->frozen != NULL)
+  {
+    return oSymTable->frozen->keys + oSymTable->frozen->keyOffsets[uSlot];
+  }
+  entry = &SymTable_imageEntries(oSymTable)[uSlot];
+  return entry->key == 0 ? NULL : SymTable_imageAt(oSymTable, entry->key);
+}
+
+/* Return the value in slot uSlot of oSymTable, which is read-only. */
+static void *SymTable_slotValue(SymTable_T oSymTable, size_t uSlot)
+{
+  if (oSymTable->frozen != NULL)
+  {
+    return oSymTable->frozen->values[uSlot];
+  }
+  return SymTable_imageValue(oSymTable, &SymTable_imageEntries(oSymTable)[uSlot]);
+}
+
+/* SymTable_findSlot returns the slot of oSymTable, which is read-only,
+whose key is pcKey, given that pcKey hashes to uHash, or
+SymTable_numOfSlots(oSymTable) if there is no such slot. */
+static size_t SymTable_findSlot(SymTable_T oSymTable, const char *pcKey, size_t uHash)
+{
+  const struct SymTable_ImageEntry *entry;
+  struct SymTable_Frozen *frozen = oSymTable->frozen;
+  size_t slot;
+
+  if (frozen == NULL)
+  {
+    entry = SymTable_findImage(oSymTable, pcKey, uHash);
+    if (entry == NULL)
+    {
+      return oSymTable->image->numOfSlots;
+    }
+    return (size_t)(entry - SymTable_imageEntries(oSymTable));
+  }
+
+  /* every key has a slot, so only the key in it can tell whether
+     pcKey is one of them */
+  if (oSymTable->length == 0)
+  {
+    return 0;
+  }
+  slot = SymTable_frozenSlot(uHash,
+    frozen->pilots[SymTable_frozenBucket(uHash, frozen->numOfBuckets)],
+    oSymTable->length);
+  if (strcmp(frozen->keys + frozen->keyOffsets[slot], pcKey) != 0)
+  {
+    return oSymTable->length;
+  }
+  return slot;
+}
+
+SymTable_T SymTable_new(void)
+{
+  return SymTable_newWithHash(SymTable_hashPolynomial, 0);
+}
+
+/* Make oSymTable an empty table whose keys are hashed by pfHash with
+   seed uSeed. */
+static void SymTable_init(SymTable_T oSymTable, SymTable_HashFunction pfHash, size_t uSeed)
+{
+  oSymTable->length = 0;
+  oSymTable->sizeIndex = 0;
+  oSymTable->hashFunction = pfHash;
+  oSymTable->seed = uSeed;
+  oSymTable->pool = NULL;
+  oSymTable->scoped = 0;
+  oSymTable->depth = 0;
+  oSymTable->latest = NULL;
+  /* only the polynomial hash needs a prime bucket count to spread
+     its weak low bits */
+  oSymTable->masked = (pfHash != SymTable_hashPolynomial);
+  if (oSymTable->masked)
+  {
+    oSymTable->numOfBuckets = (size_t)1 << MIN_BUCKET_BITS;
+  }
+  else
+  {
+    oSymTable->numOfBuckets = auBucketCounts[0];
+  }
+  oSymTable->oldBuckets = NULL;
+  oSymTable->numOfOldBuckets = 0;
+  oSymTable->migrateIndex = 0;
+  /* numOfBuckets buckets are allocated once the small array is full */
+  oSymTable->buckets = NULL;
+  oSymTable->arena = NULL;
+  oSymTable->family = NULL;
+  oSymTable->nextInFamily = NULL;
+  oSymTable->occupied = NULL;
+  oSymTable->shared = NULL;
+  oSymTable->image = NULL;
+  oSymTable->frozen = NULL;
+}
+
+SymTable_T SymTable_newWithHash(SymTable_HashFunction pfHash, size_t uSeed)
+{
+  SymTable_T oSymTable;
+
+  assert(pfHash != NULL);
+  
+  oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+  if (oSymTable == NULL)
+  {
+    return NULL;
+  }
+
+  SymTable_init(oSymTable, pfHash, uSeed);
+  return oSymTable;
+}
+
+SymTable_T SymTable_newWithPool(SymTablePool_T oPool)
+{
+  SymTable_T oSymTable;
+
+  assert(oPool != NULL);
+
+  /* hashing as the pool does lets a key's hash serve both */
+  oSymTable = SymTable_newWithHash(SymTable_hashWord, SymTablePool_seed(oPool));
+  if (oSymTable == NULL)
+  {
+    return NULL;
+  }
+  oSymTable->pool = oPool;
+  return oSymTable;
+}
+
+SymTable_T SymTable_newScoped(void)
+{
+  SymTable_T oSymTable;
+
+  oSymTable = SymTable_new();
+  if (oSymTable == NULL)
+  {
+    return NULL;
+  }
+  oSymTable->scoped = 1;
+
+  /* scopes refer to nodes by address, so a scoped table allocates its
+     buckets at once rather than keep nodes that promotion would move */
+  if (! SymTable_promote(oSymTable))
+  {
+    SymTable_free(oSymTable);
+    return NULL;
+  }
+  return oSymTable;
+}
+
+SymTable_T SymTable_clone(SymTable_T oSymTable)
+{
+  SymTable_T oClone;
+  size_t numOfWords;
+  size_t size;
+  size_t i;
+
+  assert(oSymTable != NULL);
+  assert(oSymTable->pool == NULL);
+  assert(! oSymTable->scoped);
+  assert(! SymTable_readOnly(oSymTable));
+
+  oClone = (SymTable_T)malloc(sizeof(struct SymTable));
+  if (oClone == NULL)
+  {
+    return NULL;
+  }
+
+  if (oSymTable->buckets == NULL)
+  {
+    /* a small array has too few nodes to be worth sharing */
+    *oClone = *oSymTable;
+    for (i = 0; i < oSymTable->length; i++)
+    {
+      size = SymTable_nodeSize(oSymTable,
+                               strlen(oSymTable->small[i].node->key));
+      oClone->small[i].node = malloc(size);
+      if (oClone->small[i].node == NULL)
+      {
+        while (i > 0)
+        {
+          i--;
+          free(oClone->small[i].node);
+        }
+        free(oClone);
+        return NULL;
+      }
+      memcpy(oClone->small[i].node, oSymTable->small[i].node, size);
+    }
+    return oClone;
+  }
+
+  /* chains are shared only while no expansion is in progress */
+  SymTable_migrate(oSymTable, oSymTable->numOfOldBuckets);
+  *oClone = *oSymTable;
+  numOfWords = (oSymTable->numOfBuckets + WORD_BITS - 1) / WORD_BITS;
+
+  oClone->buckets = malloc(oSymTable->numOfBuckets * sizeof(struct SymTable_Node*));
+  oClone->occupied = malloc(numOfWords * sizeof(size_t));
+  oClone->shared = malloc(numOfWords * sizeof(size_t));
+  if (oSymTable->shared == NULL)
+  {
+    oSymTable->shared = SymTable_newBitmap(oSymTable->numOfBuckets);
+  }
+  if (oSymTable->family == NULL)
+  {
+    oSymTable->family = malloc(sizeof(struct SymTable_Family));
+    if (oSymTable->family != NULL)
+    {
+      oSymTable->family->first = oSymTable;
+    }
+  }
+  if (oClone->buckets == NULL || oClone->occupied == NULL
+      || oClone->shared == NULL || oSymTable->shared == NULL
+      || oSymTable->family == NULL)
+  {
+    /* an unused sharing bitmap or family of one is harmless to keep */
+    free(oClone->shared);
+    free(oClone->occupied);
+    free(oClone->buckets);
+    free(oClone);
+    return NULL;
+  }
+
+  /* every chain that may hold a node is shared from now on */
+  memcpy(oClone->buckets, oSymTable->buckets,
+         oSymTable->numOfBuckets * sizeof(struct SymTable_Node*));
+  memcpy(oClone->occupied, oSymTable->occupied, numOfWords * sizeof(size_t));
+  for (i = 0; i < numOfWords; i++)
+  {
+    oSymTable->shared[i] |= oSymTable->occupied[i];
+  }
+  memcpy(oClone->shared, oSymTable->shared, numOfWords * sizeof(size_t));
+  oClone->family = oSymTable->family;
+  oClone->nextInFamily = oSymTable->nextInFamily;
+  oSymTable->nextInFamily = oClone;
+  return oClone;
+}
+
+void SymTable_enterScope(SymTable_T oSymTable)
+{
+  assert(oSymTable != NULL);
+  assert(oSymTable->scoped);
+
+  oSymTable->depth++;
+}
+
+/* SymTable_unbind removes the binding of oSymTable at *ppsPrevious,
+whose key has uLength characters, from its chain and frees it. The
+binding it hid, if any, takes its place. */
+static void SymTable_unbind(SymTable_T oSymTable, struct SymTable_Node **ppsPrevious, size_t uLength)
+{
+  struct SymTable_Node *node = *ppsPrevious;
+  struct SymTable_Scope *scope;
+  size_t index;
+
+  *ppsPrevious = node->next;
+  oSymTable->length--;
+  if (oSymTable->scoped)
+  {
+    scope = SymTable_scope(node);
+    if (scope->shadowed != NULL)
+    {
+      scope->shadowed->next = node->next;
+      *ppsPrevious = scope->shadowed;
+      oSymTable->length++;
+    }
+    if (scope->older != NULL)
+    {
+      SymTable_scope(scope->older)->newer = scope->newer;
+    }
+    if (scope->newer != NULL)
+    {
+      SymTable_scope(scope->newer)->older = scope->older;
+    }
+    else
+    {
+      oSymTable->latest = scope->older;
+    }
+  }
+
+  if (oSymTable->pool != NULL)
+  {
+    SymTablePool_release(oSymTable->pool, SymTable_nodeKey(oSymTable, node));
+  }
+  index = SymTable_bucket(oSymTable, node->hash, oSymTable->numOfBuckets);
+  SymTable_releaseNode(oSymTable, node, uLength);
+  if (oSymTable->buckets[index] == NULL)
+  {
+    oSymTable->occupied[index / WORD_BITS] &= ~((size_t)1 << (index % WORD_BITS));
+  }
+}
+
+void SymTable_exitScope(SymTable_T oSymTable)
+{
+  struct SymTable_Node **previous;
+  struct SymTable_Node *node;
+
+  assert(oSymTable != NULL);
+  assert(oSymTable->scoped);
+  assert(oSymTable->depth > 0);
+
+  /* the scope's bindings are the newest, and each is in a chain,
+     since only bindings of enclosing scopes are hidden */
+  while (oSymTable->latest != NULL
+         && SymTable_scope(oSymTable->latest)->depth == oSymTable->depth)
+  {
+    node = oSymTable->latest;
+    for (previous = SymTable_chain(oSymTable, node->hash);
+         *previous != node;
+         previous = &(*previous)->next)
+    {
+    }
+    SymTable_unbind(oSymTable, previous,
+                    strlen(SymTable_nodeKey(oSymTable, node)));
+  }
+  oSymTable->depth--;
+}
+
+/* Return pcKey, a key of a table created against the pool pvPool, to
+   the pool. */
+static void SymTable_releaseKey(const char *pcKey, void *pvValue, void *pvPool)
+{
+  (void)pvValue;
+  SymTablePool_release((SymTablePool_T)pvPool, pcKey);
+}
+
+/* Return to the arena of oSymTable every node of the chain that
+   begins with first. */
+static void SymTable_releaseChain(SymTable_T oSymTable, struct SymTable_Node *first)
+{
+  struct SymTable_Node *current;
+  struct SymTable_Node *forward;
+
+  for (current = first; current != NULL; current = forward)
+  {
+    forward = current->next;
+    SymTable_releaseNode(oSymTable, current, strlen(current->key));
+  }
+}
+
+/* Return to the arena of oSymTable every node of every chain that no
+   other table of its family reaches. */
+static void SymTable_releaseOwned(SymTable_T oSymTable)
+{
+  size_t i;
+
+  for (i = oSymTable->migrateIndex; i < oSymTable->numOfOldBuckets; i++)
+  {
+    SymTable_releaseChain(oSymTable, oSymTable->oldBuckets[i]);
+  }
+  for (i = 0; i < oSymTable->numOfBuckets; i++)
+  {
+    if (oSymTable->shared == NULL
+        || (oSymTable->shared[i / WORD_BITS]
+            & ((size_t)1 << (i % WORD_BITS))) == 0
+        || ! SymTable_chainReferenced(oSymTable, i))
+    {
+      SymTable_releaseChain(oSymTable, oSymTable->buckets[i]);
+    }
+  }
+}
+
+/* SymTable_leaveFamily removes oSymTable from its family. If just one
+table is left, that table shares nothing any more, so it forgets its
+sharing bitmap and its family, and changes its chains in place. */
+static void SymTable_leaveFamily(SymTable_T oSymTable)
+{
+  struct SymTable_Family *family = oSymTable->family;
+  struct SymTable **previous;
+  struct SymTable *last;
+
+  for (previous = &family->first;
+       *previous != oSymTable;
+       previous = &(*previous)->nextInFamily)
+  {
+  }
+  *previous = oSymTable->nextInFamily;
+
+  last = family->first;
+  if (last->nextInFamily == NULL)
+  {
+    free(last->shared);
+    last->shared = NULL;
+    last->family = NULL;
+    free(family);
+  }
+}
+
+/* SymTable_clear frees all memory that oSymTable occupies except its
+SymTable structure, leaving the structure to be initialized again. */
+static void SymTable_clear(SymTable_T oSymTable)
+{
+  size_t i;
+
+  if (oSymTable->image != NULL)
+  {
+    munmap((void*)oSymTable->image, oSymTable->image->size);
+    return;
+  }
+
+  if (oSymTable->frozen != NULL)
+  {
+    free(oSymTable->frozen->keys);
+    free(oSymTable->frozen->pilots);
+    free(oSymTable->frozen->values);
+    free(oSymTable->frozen->keyOffsets);
+    free(oSymTable->frozen);
+    return;
+  }
+
+  if (oSymTable->pool != NULL)
+  {
+    SymTable_map(oSymTable, SymTable_releaseKey, oSymTable->pool);
+  }
+
+  if (oSymTable->buckets == NULL)
+  {
+    for (i = 0; i < oSymTable->length; i++)
+    {
+      free(oSymTable->small[i].node);
+    }
+    return;
+  }
+
+  if (oSymTable->family != NULL && oSymTable->family->first->nextInFamily != NULL)
+  {
+    /* the rest of the family still uses the arena, so only the nodes
+       that no other table reaches go back to it */
+    SymTable_releaseOwned(oSymTable);
+    SymTable_leaveFamily(oSymTable);
+  }
+  else
+  {
+    /* every node lives in the arena, so no chain needs to be walked */
+    SymTableArena_free(oSymTable->arena);
+    free(oSymTable->family);
+  }
+  free(oSymTable->shared);
+  free(oSymTable->occupied);
+  free(oSymTable->oldBuckets);
+  free(oSymTable->buckets);
+}
+
+void SymTable_free(SymTable_T oSymTable)
+{
+  assert(oSymTable != NULL);
+
+  SymTable_clear(oSymTable);
+  free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+  assert(oSymTable != NULL);
+  
+  return oSymTable->length;
+}
+
+SymTable_Key SymTable_hashKey(SymTable_T oSymTable, const char *pcKey)
+{
+  SymTable_Key oKey;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  oKey.hash = SymTable_hash(oSymTable, pcKey);
+  oKey.length = strlen(pcKey);
+  return oKey;
+}
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue)
+{
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  return SymTable_putHashed(oSymTable, pcKey, SymTable_hashKey(oSymTable, pcKey), pvValue);
+}
+
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey, SymTable_Key oKey, const void *pvValue)
+{
+  struct SymTable_Node **chain;
+  struct SymTable_Node *newNode;
+  struct SymTable_Node *found;
+  struct SymTable_Scope *scope;
+  size_t hash = oKey.hash;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+  assert(! SymTable_readOnly(oSymTable));
+
+  SymTable_migrate(oSymTable, MIGRATE_STEP);
+
+  /* a scoped table binds a key again in a scope inside the one that
+     bound it */
+  found = SymTable_find(oSymTable, pcKey, hash);
+  if (found != NULL
+      && ! (oSymTable->scoped
+            && SymTable_scope(found)->depth < oSymTable->depth))
+  {
+    return 0;
+  }
+
+  if (oSymTable->buckets == NULL)
+  {
+    if (oSymTable->length < SMALL_CAPACITY)
+    {
+      newNode = malloc(SymTable_nodeSize(oSymTable, oKey.length));
+      if (newNode == NULL)
+      {
+        return 0;
+      }
+      if (! SymTable_setNodeKey(oSymTable, newNode, pcKey, oKey))
+      {
+        free(newNode);
+        return 0;
+      }
+      newNode->value = (void*) pvValue;
+      newNode->hash = hash;
+      newNode->next = NULL;
+      oSymTable->small[oSymTable->length].hash = hash;
+      oSymTable->small[oSymTable->length].node = newNode;
+      oSymTable->length++;
+      return 1;
+    }
+    if (! SymTable_promote(oSymTable))
+    {
+      return 0;
+    }
+  }
+
+  /* allocate memory for newNode structure and its defensive copy of
+     pcKey together, now that the binding is known to be new */
+  newNode = SymTable_allocNode(oSymTable, oKey.length);
+  if (newNode == NULL)
+  {
+    return 0;
+  }
+  if (! SymTable_setNodeKey(oSymTable, newNode, pcKey, oKey))
+  {
+    SymTable_releaseNode(oSymTable, newNode, oKey.length);
+    return 0;
+  }
+  newNode->value = (void*) pvValue;
+  newNode->hash = hash;
+
+  if (found != NULL)
+  {
+    /* newNode hides found by taking its place in its chain */
+    for (chain = SymTable_chain(oSymTable, hash);
+         *chain != found;
+         chain = &(*chain)->next)
+    {
+    }
+    newNode->next = found->next;
+    *chain = newNode;
+  }
+  else
+  {
+    /* expansion check: keep the load factor at or below one binding
+       per bucket */
+    if (oSymTable->length >= oSymTable->numOfBuckets)
+    {
+      SymTable_expand(oSymTable);
+    }
+
+    /* a chain shared with a clone is copied before it changes */
+    if (! SymTable_own(oSymTable, hash))
+    {
+      SymTable_releaseNode(oSymTable, newNode, oKey.length);
+      return 0;
+    }
+    chain = SymTable_chain(oSymTable, hash);
+    newNode->next = *chain;
+    *chain = newNode;
+    /* the node reaches this current bucket now or when its old bucket
+       is migrated */
+    SymTable_setOccupied(oSymTable,
+                         SymTable_bucket(oSymTable, hash, oSymTable->numOfBuckets));
+    oSymTable->length++;
+  }
+
+  if (oSymTable->scoped)
+  {
+    scope = SymTable_scope(newNode);
+    scope->depth = oSymTable->depth;
+    scope->shadowed = found;
+    scope->older = oSymTable->latest;
+    scope->newer = NULL;
+    if (oSymTable->latest != NULL)
+    {
+      SymTable_scope(oSymTable->latest)->newer = newNode;
+    }
+    oSymTable->latest = newNode;
+  }
+  return 1;
+}
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue)
+{
+  struct SymTable_Node *current;
+  void *oldVal;
+  size_t hash;
+  
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+  assert(! SymTable_readOnly(oSymTable));
+
+  SymTable_migrate(oSymTable, MIGRATE_STEP);
+
+  hash = SymTable_hash(oSymTable, pcKey);
+  current = SymTable_find(oSymTable, pcKey, hash);
+  if (current == NULL)
+  {
+    return NULL;
+  }
+
+  /* a node shared with a clone is copied before its value changes */
+  if (oSymTable->shared != NULL)
+  {
+    if (! SymTable_own(oSymTable, hash))
+    {
+      return NULL;
+    }
+    current = SymTable_find(oSymTable, pcKey, hash);
+  }
+
+  oldVal = current->value;
+  current->value = (void*) pvValue;
+  return oldVal;
+}
+    
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+  struct SymTable_Node *current;
+  
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  if (SymTable_readOnly(oSymTable))
+  {
+    return SymTable_findSlot(oSymTable, pcKey, SymTable_hash(oSymTable, pcKey))
+      != SymTable_numOfSlots(oSymTable);
+  }
+
+  SymTable_migrate(oSymTable, MIGRATE_STEP);
+
+  current = SymTable_find(oSymTable, pcKey, SymTable_hash(oSymTable, pcKey));
+  return current != NULL;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+  struct SymTable_Node *current;
+  
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  if (SymTable_readOnly(oSymTable))
+  {
+    return SymTable_getHashed(oSymTable, pcKey,
+                              SymTable_hashKey(oSymTable, pcKey));
+  }
+
+  SymTable_migrate(oSymTable, MIGRATE_STEP);
+
+  current = SymTable_find(oSymTable, pcKey, SymTable_hash(oSymTable, pcKey));
+  if (current == NULL)
+  {
+    return NULL;
+  }
+  return current->value;
+
+}
+
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey, SymTable_Key oKey)
+{
+  struct SymTable_Node *current;
+  size_t slot;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  if (SymTable_readOnly(oSymTable))
+  {
+    slot = SymTable_findSlot(oSymTable, pcKey, oKey.hash);
+    if (slot == SymTable_numOfSlots(oSymTable))
+    {
+      return NULL;
+    }
+    return SymTable_slotValue(oSymTable, slot);
+  }
+
+  SymTable_migrate(oSymTable, MIGRATE_STEP);
+
+  current = SymTable_find(oSymTable, pcKey, oKey.hash);
+  if (current == NULL)
+  {
+    return NULL;
+  }
+  return current->value;
+}
+
+void SymTable_getMany(SymTable_T oSymTable, const char *const ppcKeys[], size_t uCount, void *ppvValues[])
+{
+  struct SymTable_Node *found[BATCH_SIZE];
+  size_t batch;
+  size_t i;
+
+  assert(oSymTable != NULL);
+  assert(ppcKeys != NULL || uCount == 0);
+  assert(ppvValues != NULL || uCount == 0);
+
+  /* a read-only table has no chains to prefetch along */
+  if (SymTable_readOnly(oSymTable))
+  {
+    for (i = 0; i < uCount; i++)
+    {
+      ppvValues[i] = SymTable_get(oSymTable, ppcKeys[i]);
+    }
+    return;
+  }
+
+  SymTable_migrate(oSymTable, MIGRATE_STEP);
+
+  for (; uCount > 0; uCount -= batch)
+  {
+    batch = uCount < BATCH_SIZE ? uCount : BATCH_SIZE;
+    SymTable_findBatch(oSymTable, ppcKeys, batch, found);
+    for (i = 0; i < batch; i++)
+    {
+      ppvValues[i] = found[i] == NULL ? NULL : found[i]->value;
+    }
+    ppcKeys += batch;
+    ppvValues += batch;
+  }
+}
+
+void SymTable_containsMany(SymTable_T oSymTable, const char *const ppcKeys[], size_t uCount, int piFound[])
+{
+  struct SymTable_Node *found[BATCH_SIZE];
+  size_t batch;
+  size_t i;
+
+  assert(oSymTable != NULL);
+  assert(ppcKeys != NULL || uCount == 0);
+  assert(piFound != NULL || uCount == 0);
+
+  if (SymTable_readOnly(oSymTable))
+  {
+    for (i = 0; i < uCount; i++)
+    {
+      piFound[i] = SymTable_contains(oSymTable, ppcKeys[i]);
+    }
+    return;
+  }
+
+  SymTable_migrate(oSymTable, MIGRATE_STEP);
+
+  for (; uCount > 0; uCount -= batch)
+  {
+    batch = uCount < BATCH_SIZE ? uCount : BATCH_SIZE;
+    SymTable_findBatch(oSymTable, ppcKeys, batch, found);
+    for (i = 0; i < batch; i++)
+    {
+      piFound[i] = found[i] != NULL;
+    }
+    ppcKeys += batch;
+    piFound += batch;
+  }
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  return SymTable_removeHashed(oSymTable, pcKey, SymTable_hashKey(oSymTable, pcKey));
+}
+
+void *SymTable_removeHashed(SymTable_T oSymTable, const char *pcKey, SymTable_Key oKey)
+{
+  const void *holdVal;
+  struct SymTable_Node **previous;
+  struct SymTable_Node *current;
+  size_t hash = oKey.hash;
+  size_t index;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+  assert(! SymTable_readOnly(oSymTable));
+
+  SymTable_migrate(oSymTable, MIGRATE_STEP);
+
+  if (oSymTable->buckets == NULL)
+  {
+    /* the last binding fills the hole */
+    index = SymTable_findSmall(oSymTable, pcKey, hash);
+    if (index == SMALL_CAPACITY)
+    {
+      return NULL;
+    }
+    holdVal = oSymTable->small[index].node->value;
+    if (oSymTable->pool != NULL)
+    {
+      SymTablePool_release(oSymTable->pool,
+                           SymTable_nodeKey(oSymTable, oSymTable->small[index].node));
+    }
+    free(oSymTable->small[index].node);
+    oSymTable->length--;
+    oSymTable->small[index] = oSymTable->small[oSymTable->length];
+    return (void*) holdVal;
+  }
+
+  /* a chain shared with a clone is copied before it changes, but only
+     if it holds pcKey */
+  if (oSymTable->shared != NULL
+      && (SymTable_find(oSymTable, pcKey, hash) == NULL
+          || ! SymTable_own(oSymTable, hash)))
+  {
+    return NULL;
+  }
+
+  /* If a binding in the SymTable_T structure has a key that matches pcKey,
+ the SymTable_Node is unlinked from its chain and the binding's value is returned.
+ Otherwise, NULL is returned. */
+  for (previous = SymTable_chain(oSymTable, hash);
+       *previous != NULL;
+       previous = &current->next)
+  {
+    current = *previous;
+    if (SymTable_matches(oSymTable, current, pcKey, hash))
+    {
+      holdVal = current->value;
+      SymTable_unbind(oSymTable, previous, oKey.length);
+      return (void*) holdVal;
+    }
+  }
+
+  return NULL;
+}
+
+/* SymTable_seek positions poIterator at the first binding of oSymTable
+in a bucket numbered uFirst or higher, skipping the empty buckets that
+the occupancy bitmap marks. It returns 1, or 0 if there is no such
+binding. oSymTable must have no old buckets. */
+static int SymTable_seek(SymTable_T oSymTable, SymTable_Iterator *poIterator, size_t uFirst)
+{
+  size_t numOfWords;
+  size_t word;
+  size_t bits;
+  size_t index;
+
+  poIterator->node = NULL;
+  if (SymTable_readOnly(oSymTable))
+  {
+    /* each slot of a read-only table counts as a bucket, and the
+       iterator points at the key in it */
+    for (index = uFirst; index < SymTable_numOfSlots(oSymTable); index++)
+    {
+      if (SymTable_slotKey(oSymTable, index) != NULL)
+      {
+        poIterator->node = (void*)SymTable_slotKey(oSymTable, index);
+        poIterator->bucket = index;
+        return 1;
+      }
+    }
+    return 0;
+  }
+  if (oSymTable->buckets == NULL)
+  {
+    /* each entry of the small array counts as a bucket */
+    if (uFirst >= oSymTable->length)
+    {
+      return 0;
+    }
+    poIterator->node = oSymTable->small[uFirst].node;
+    poIterator->bucket = uFirst;
+    return 1;
+  }
+  if (uFirst >= oSymTable->numOfBuckets)
+  {
+    return 0;
+  }
+
+  numOfWords = (oSymTable->numOfBuckets + WORD_BITS - 1) / WORD_BITS;
+  word = uFirst / WORD_BITS;
+  bits = oSymTable->occupied[word] & (~(size_t)0 << (uFirst % WORD_BITS));
+  for (;;)
+  {
+    while (bits == 0)
+    {
+      word++;
+      if (word == numOfWords)
+      {
+        return 0;
+      }
+      bits = oSymTable->occupied[word];
+    }
+
+    /* a set bit may belong to a bucket whose node is still waiting in
+       an old bucket, so the bucket itself decides */
+    index = word * WORD_BITS + SymTable_lowestBit(bits);
+    if (oSymTable->buckets[index] != NULL)
+    {
+      poIterator->node = oSymTable->buckets[index];
+      poIterator->bucket = index;
+      return 1;
+    }
+    bits &= bits - 1;
+  }
+}
+
+int SymTable_begin(SymTable_T oSymTable, SymTable_Iterator *poIterator)
+{
+  assert(oSymTable != NULL);
+  assert(poIterator != NULL);
+
+  /* finishing any migration now keeps later lookups, which would
+     otherwise migrate, from moving nodes under the iterator */
+  SymTable_migrate(oSymTable, oSymTable->numOfOldBuckets);
+
+  poIterator->table = oSymTable;
+  return SymTable_seek(oSymTable, poIterator, 0);
+}
+
+int SymTable_next(SymTable_T oSymTable, SymTable_Iterator *poIterator)
+{
+  struct SymTable_Node *current;
+
+  assert(oSymTable != NULL);
+  assert(poIterator != NULL);
+
+  current = poIterator->node;
+  if (current == NULL)
+  {
+    return 0;
+  }
+  if (! SymTable_readOnly(oSymTable) && current->next != NULL)
+  {
+    poIterator->node = current->next;
+    return 1;
+  }
+  return SymTable_seek(oSymTable, poIterator, poIterator->bucket + 1);
+}
+
+const char *SymTable_key(const SymTable_Iterator *poIterator)
+{
+  SymTable_T oSymTable;
+
+  assert(poIterator != NULL);
+  assert(poIterator->node != NULL);
+
+  oSymTable = (SymTable_T)poIterator->table;
+  if (SymTable_readOnly(oSymTable))
+  {
+    return (const char*)poIterator->node;
+  }
+  return SymTable_nodeKey((SymTable_T)poIterator->table,
+                          (struct SymTable_Node*)poIterator->node);
+}
+
+void *SymTable_value(const SymTable_Iterator *poIterator)
+{
+  SymTable_T oSymTable;
+
+  assert(poIterator != NULL);
+  assert(poIterator->node != NULL);
+
+  oSymTable = (SymTable_T)poIterator->table;
+  if (SymTable_readOnly(oSymTable))
+  {
+    return SymTable_slotValue(oSymTable, poIterator->bucket);
+  }
+  return ((struct SymTable_Node*)poIterator->node)->value;
+}
+
+/* Return the number of buckets of oSymTable that may hold bindings:
+   the old buckets not yet migrated, then every current bucket. Without
+   buckets, each binding of the small array counts as one, and each slot
+   of a read-only table does. */
+static size_t SymTable_rangeLength(SymTable_T oSymTable)
+{
+  if (SymTable_readOnly(oSymTable))
+  {
+    return SymTable_numOfSlots(oSymTable);
+  }
+  if (oSymTable->buckets == NULL)
+  {
+    return oSymTable->length;
+  }
+  return oSymTable->numOfOldBuckets - oSymTable->migrateIndex
+    + oSymTable->numOfBuckets;
+}
+
+/* SymTable_mapBuckets applies *pfApply to each binding in the buckets of
+oSymTable numbered uFirst up to but not including uLast, passing pvExtra.
+The old buckets not yet migrated are numbered first, then the current
+buckets, up to SymTable_rangeLength(oSymTable). */
+static void SymTable_mapBuckets(SymTable_T oSymTable, size_t uFirst, size_t uLast, void(*pfApply)(const char *pcKey, void *pvValue, void *pvExtra), void *pvExtra)
+{
+ struct SymTable_Node *current;
+ struct SymTable_Node *forward;
+ size_t numOfOld;
+ size_t i;
+
+ if (SymTable_readOnly(oSymTable))
+ {
+   for (i = uFirst; i < uLast; i++)
+   {
+     if (SymTable_slotKey(oSymTable, i) != NULL)
+     {
+       (*pfApply)(SymTable_slotKey(oSymTable, i),
+                  SymTable_slotValue(oSymTable, i), pvExtra);
+     }
+   }
+   return;
+ }
+
+ /* old buckets below migrateIndex are already empty */
+ numOfOld = oSymTable->numOfOldBuckets - oSymTable->migrateIndex;
+
+ for (i = uFirst; i < uLast; i++)
+ {
+   if (oSymTable->buckets == NULL)
+   {
+     current = oSymTable->small[i].node;
+   }
+   else if (i < numOfOld)
+   {
+     current = oSymTable->oldBuckets[oSymTable->migrateIndex + i];
+   }
+   else
+   {
+     current = oSymTable->buckets[i - numOfOld];
+   }
+   while (current != NULL)
+   {
+     (*pfApply)(SymTable_nodeKey(oSymTable, current), (void*)current->value,
+                pvExtra);
+     forward = current->next;
+     current = forward;
+   }
+ }
+}
+
+void SymTable_map(SymTable_T oSymTable, void(*pfApply)(const char *pcKey, void *pvValue, void *pvExtra), const void *pvExtra)
+{
+ assert(oSymTable != NULL);
+ assert(pfApply != NULL);
+
+ SymTable_mapBuckets(oSymTable, 0, SymTable_rangeLength(oSymTable), pfApply,
+                   (void*)pvExtra);
+}
+
+/* Return the first of uLength buckets that the worker numbered i of
+   uThreads visits. The workers' ranges differ in length by at most one. */
+static size_t SymTable_rangeStart(size_t uLength, size_t uThreads, size_t i)
+{
+ return uLength / uThreads * i
+   + (i < uLength % uThreads ? i : uLength % uThreads);
+}
+
+/* Run the SymTable_MapWorker pvWorker. Return NULL. */
+static void *SymTable_runMapWorker(void *pvWorker)
+{
+ struct SymTable_MapWorker *worker = pvWorker;
+
+ SymTable_mapBuckets(worker->table, worker->first, worker->last,
+                   worker->apply, worker->extra);
+ return NULL;
+}
+
+void SymTable_mapParallel(SymTable_T oSymTable, size_t uThreads, void(*pfApply)(const char *pcKey, void *pvValue, void *pvExtra), void *ppvExtras[], void(*pfReduce)(void *pvExtra, void *pvTotal), void *pvTotal)
+{
+ struct SymTable_MapWorker *workers;
+ size_t rangeLength;
+ size_t i;
+
+ assert(oSymTable != NULL);
+ assert(uThreads > 0);
+ assert(pfApply != NULL);
+ assert(ppvExtras != NULL);
+
+ rangeLength = SymTable_rangeLength(oSymTable);
+
+ workers = calloc(uThreads, sizeof(struct SymTable_MapWorker));
+ if (workers == NULL)
+ {
+   /* without memory for the workers, visit their ranges in turn */
+   for (i = 0; i < uThreads; i++)
    {
-     (*pfApply)((void*)current->key, (void*)current->value, (void*)pvExtra);
-     forward = current->next;
-     current = forward;
+     SymTable_mapBuckets(oSymTable,
+                       SymTable_rangeStart(rangeLength, uThreads, i),
+                       SymTable_rangeStart(rangeLength, uThreads, i + 1),
+                       pfApply, ppvExtras[i]);
+   }
+ }
+ else
+ {
+   /* the calling thread runs worker 0 itself */
+   for (i = 0; i < uThreads; i++)
+   {
+     workers[i].table = oSymTable;
+     workers[i].first = SymTable_rangeStart(rangeLength, uThreads, i);
+     workers[i].last = SymTable_rangeStart(rangeLength, uThreads, i + 1);
+     workers[i].apply = pfApply;
+     workers[i].extra = ppvExtras[i];
+   }
+   for (i = 1; i < uThreads; i++)
+   {
+     workers[i].started = pthread_create(&workers[i].thread, NULL,
+                                         SymTable_runMapWorker,
+                                         &workers[i]) == 0;
+   }
+
+   /* a worker whose thread could not be started runs here instead */
+   for (i = 0; i < uThreads; i++)
+   {
+     if (! workers[i].started)
+     {
+       SymTable_runMapWorker(&workers[i]);
+     }
+   }
+   for (i = 1; i < uThreads; i++)
+   {
+     if (workers[i].started)
+     {
+       pthread_join(workers[i].thread, NULL);
+     }
+   }
+   free(workers);
+ }
+
+ if (pfReduce != NULL)
+ {
+   for (i = 0; i < uThreads; i++)
+   {
+     (*pfReduce)(ppvExtras[i], pvTotal);
    }
  }
- 
+}
+
+/* Where SymTable_save is writing an image, and how much of it */
+struct SymTable_Saving
+{
+  FILE *file;
+  /* Offset at which the next key is written */
+  size_t offset;
+  /* Entries of the image, or NULL once they have been written */
+  struct SymTable_ImageEntry *entries;
+  size_t numOfSlots;
+  size_t seed;
+  /* Function that gives the size of a value */
+  size_t (*valueSize)(const void *pvValue);
+  /* 1 until a write fails */
+  int ok;
+};
+
+/* Return uOffset rounded up to a multiple of IMAGE_ALIGN. */
+static size_t SymTable_alignImage(size_t uOffset)
+{
+  return (uOffset + IMAGE_ALIGN - 1) / IMAGE_ALIGN * IMAGE_ALIGN;
+}
+
+/* Write uSize bytes at pvBytes to psFile. Return 1, or 0 if they could
+   not all be written. */
+static int SymTable_write(FILE *psFile, const void *pvBytes, size_t uSize)
+{
+  return fwrite(pvBytes, 1, uSize, psFile) == uSize;
+}
+
+/* Write to psFile the zero bytes that take uOffset up to a multiple of
+   IMAGE_ALIGN. Return 1, or 0 if they could not all be written. */
+static int SymTable_pad(FILE *psFile, size_t uOffset)
+{
+  static const char acZeros[IMAGE_ALIGN] = {0};
+
+  return SymTable_write(psFile, acZeros, SymTable_alignImage(uOffset) - uOffset);
+}
+
+/* A temporary file that SymTable_save writes an image into */
+struct SymTable_Temporary
+{
+  /* Descriptor of the file, open for writing */
+  int descriptor;
+  /* Name of the file */
+  char name[];
+};
+
+/* Create a new file, named after pcFilename and in the same directory,
+   with the permissions a new pcFilename would get. Return it, or NULL
+   if it cannot be created or there is insufficient memory. */
+static struct SymTable_Temporary *SymTable_openTemporary(const char *pcFilename)
+{
+  struct SymTable_Temporary *temporary;
+  size_t size;
+  int attempt;
+
+  /* room for a '.', the hex digits of a size_t, ".tmp", and a '\0' */
+  size = strlen(pcFilename) + 2 * sizeof(size_t) + 6;
+  temporary = malloc(sizeof(struct SymTable_Temporary) + size);
+  if (temporary == NULL)
+  {
+    return NULL;
+  }
+
+  for (attempt = 0; attempt < TEMP_ATTEMPTS; attempt++)
+  {
+    sprintf(temporary->name, "%s.%lx.tmp", pcFilename,
+            (unsigned long)SymTable_randomSeed());
+    temporary->descriptor = open(temporary->name,
+                                 O_WRONLY | O_CREAT | O_EXCL, 0666);
+    if (temporary->descriptor >= 0)
+    {
+      return temporary;
+    }
+    if (errno != EEXIST)
+    {
+      break;
+    }
+  }
+  free(temporary);
+  return NULL;
+}
+
+/* SymTable_place places the binding of pcKey to pvValue at the offset
+of the SymTable_Saving pvSaving: it fills the binding's slot and moves
+the offset past the key and the value. Once the entries have been
+written, it writes the key and the value there instead, each followed
+by the zero bytes that align the next. */
+static void SymTable_place(const char *pcKey, void *pvValue, void *pvSaving)
+{
+  struct SymTable_Saving *saving = pvSaving;
+  size_t hash;
+  size_t index;
+  size_t length = strlen(pcKey) + 1;
+  size_t size = 0;
+
+  if (pvValue != NULL)
+  {
+    size = (*saving->valueSize)(pvValue);
+  }
+
+  if (saving->entries != NULL)
+  {
+    hash = SymTable_hashWord(pcKey, saving->seed);
+    for (index = hash & (saving->numOfSlots - 1);
+         saving->entries[index].key != 0;
+         index = (index + 1) & (saving->numOfSlots - 1))
+    {
+    }
+    saving->entries[index].hash = hash;
+    saving->entries[index].key = saving->offset;
+    saving->entries[index].value = 0;
+    if (pvValue != NULL)
+    {
+      saving->entries[index].value = SymTable_alignImage(saving->offset + length);
+    }
+  }
+  else if (saving->ok)
+  {
+    /* the value starts aligned, so its size alone decides its padding */
+    saving->ok = SymTable_write(saving->file, pcKey, length)
+      && SymTable_pad(saving->file, saving->offset + length)
+      && (pvValue == NULL
+          || (SymTable_write(saving->file, pvValue, size)
+              && SymTable_pad(saving->file, size)));
+  }
+
+  saving->offset = SymTable_alignImage(saving->offset + length);
+  if (pvValue != NULL)
+  {
+    saving->offset += SymTable_alignImage(size);
+  }
+}
+
+int SymTable_save(SymTable_T oSymTable, const char *pcFilename, size_t (*pfValueSize)(const void *pvValue))
+{
+  static const char acZeros[IMAGE_ALIGN] = {0};
+  struct SymTable_Image header;
+  struct SymTable_Saving saving;
+  struct SymTable_Temporary *temporary;
+  int descriptor;
+
+  assert(oSymTable != NULL);
+  assert(pcFilename != NULL);
+  assert(pfValueSize != NULL);
+
+  /* a load factor of at most one half keeps probes short */
+  saving.numOfSlots = 1;
+  while (saving.numOfSlots < 2 * oSymTable->length)
+  {
+    saving.numOfSlots *= 2;
+  }
+  saving.entries = calloc(saving.numOfSlots, sizeof(struct SymTable_ImageEntry));
+  if (saving.entries == NULL)
+  {
+    return 0;
+  }
+
+  /* the image is always hashed with SymTable_hashWord, whatever the
+     table's hash function, since a function cannot be saved */
+  memcpy(header.magic, acImageMagic, sizeof(header.magic));
+  header.wordSize = sizeof(size_t);
+  header.order = IMAGE_ORDER;
+  header.length = oSymTable->length;
+  header.numOfSlots = saving.numOfSlots;
+  header.seed = SymTable_randomSeed();
+  header.entries = sizeof(struct SymTable_Image);
+
+  /* the first pass fills the slots and sizes the image, and the
+     second writes the keys and values in the same order */
+  saving.offset = SymTable_alignImage(header.entries + saving.numOfSlots
+                                      * sizeof(struct SymTable_ImageEntry));
+  saving.file = NULL;
+  saving.seed = header.seed;
+  saving.valueSize = pfValueSize;
+  saving.ok = 1;
+  SymTable_map(oSymTable, SymTable_place, &saving);
+  header.size = saving.offset + IMAGE_ALIGN;
+
+  /* the image is written beside pcFilename and renamed over it once
+     complete, so a process that has the old image mapped keeps it */
+  temporary = SymTable_openTemporary(pcFilename);
+  if (temporary == NULL)
+  {
+    free(saving.entries);
+    return 0;
+  }
+  descriptor = temporary->descriptor;
+  saving.file = fdopen(descriptor, "wb");
+  if (saving.file == NULL)
+  {
+    close(descriptor);
+    remove(temporary->name);
+    free(temporary);
+    free(saving.entries);
+    return 0;
+  }
+  saving.offset = header.entries + saving.numOfSlots
+    * sizeof(struct SymTable_ImageEntry);
+  saving.ok = SymTable_write(saving.file, &header, sizeof(header))
+    && SymTable_write(saving.file, saving.entries,
+                      saving.numOfSlots * sizeof(struct SymTable_ImageEntry))
+    && SymTable_pad(saving.file, saving.offset);
+  free(saving.entries);
+  saving.entries = NULL;
+
+  saving.offset = SymTable_alignImage(saving.offset);
+  SymTable_map(oSymTable, SymTable_place, &saving);
+  saving.ok = saving.ok && SymTable_write(saving.file, acZeros, IMAGE_ALIGN)
+    && fflush(saving.file) == 0 && fsync(descriptor) == 0;
+  saving.ok = fclose(saving.file) == 0 && saving.ok;
+
+  /* a partial image must never replace a whole one */
+  saving.ok = saving.ok && rename(temporary->name, pcFilename) == 0;
+  if (! saving.ok)
+  {
+    remove(temporary->name);
+  }
+  free(temporary);
+  return saving.ok;
+}
+
+/* Return 1 if image, which has uSize bytes, is an image written by
+   SymTable_save on a machine like this one, or 0 otherwise. Every slot
+   is checked, so that no key or value lies outside the image and a
+   lookup always reaches an empty slot, but no key or value is read. */
+static int SymTable_validImage(const struct SymTable_Image *image, size_t uSize)
+{
+  const struct SymTable_ImageEntry *entries;
+  size_t keys;
+  size_t used = 0;
+  size_t i;
+
+  if (memcmp(image->magic, acImageMagic, sizeof(image->magic)) != 0
+      || image->wordSize != sizeof(size_t) || image->order != IMAGE_ORDER
+      || image->size != uSize)
+  {
+    return 0;
+  }
+  if (image->numOfSlots == 0
+      || (image->numOfSlots & (image->numOfSlots - 1)) != 0
+      || image->length >= image->numOfSlots)
+  {
+    return 0;
+  }
+
+  /* the entries must lie within the image, after the header and
+     aligned for their fields */
+  if (image->entries % sizeof(size_t) != 0
+      || image->entries < sizeof(struct SymTable_Image)
+      || image->entries > uSize
+      || (uSize - image->entries) / sizeof(struct SymTable_ImageEntry)
+         < image->numOfSlots)
+  {
+    return 0;
+  }
+  keys = image->entries + image->numOfSlots * sizeof(struct SymTable_ImageEntry);
+
+  /* the image ends with a zero byte, so each key ends within it */
+  if (uSize < keys + IMAGE_ALIGN || ((const char*)image)[uSize - 1] != 0)
+  {
+    return 0;
+  }
+
+  entries = (const struct SymTable_ImageEntry*)
+    ((const char*)image + image->entries);
+  for (i = 0; i < image->numOfSlots; i++)
+  {
+    if (entries[i].key == 0)
+    {
+      continue;
+    }
+    if (entries[i].key < keys || entries[i].key >= uSize
+        || (entries[i].value != 0
+            && (entries[i].value <= entries[i].key
+                || entries[i].value > uSize
+                || entries[i].value % IMAGE_ALIGN != 0)))
+    {
+      return 0;
+    }
+    used++;
+  }
+  return used == image->length;
+}
+
+SymTable_T SymTable_loadMapped(const char *pcFilename)
+{
+  SymTable_T oSymTable;
+  struct stat sStat;
+  void *pvImage;
+  int iDescriptor;
+
+  assert(pcFilename != NULL);
+
+  iDescriptor = open(pcFilename, O_RDONLY);
+  if (iDescriptor < 0)
+  {
+    return NULL;
+  }
+  if (fstat(iDescriptor, &sStat) != 0
+      || (size_t)sStat.st_size < sizeof(struct SymTable_Image))
+  {
+    close(iDescriptor);
+    return NULL;
+  }
+
+  /* the mapping keeps the file open once the descriptor is closed */
+  pvImage = mmap(NULL, (size_t)sStat.st_size, PROT_READ, MAP_PRIVATE,
+                 iDescriptor, 0);
+  close(iDescriptor);
+  if (pvImage == MAP_FAILED)
+  {
+    return NULL;
+  }
+  if (! SymTable_validImage(pvImage, (size_t)sStat.st_size))
+  {
+    munmap(pvImage, (size_t)sStat.st_size);
+    return NULL;
+  }
+
+  oSymTable = SymTable_newWithHash(SymTable_hashWord,
+                                   ((struct SymTable_Image*)pvImage)->seed);
+  if (oSymTable == NULL)
+  {
+    munmap(pvImage, (size_t)sStat.st_size);
+    return NULL;
+  }
+  oSymTable->image = pvImage;
+  oSymTable->length = oSymTable->image->length;
+  return oSymTable;
+}
+
+/* A binding that SymTable_freeze gathers from a table */
+struct SymTable_Gathered
+{
+  const char *key;
+  void *value;
+};
+
+/* The bindings that SymTable_freeze gathers from a table */
+struct SymTable_Gathering
+{
+  /* Bindings, in the order SymTable_map visits them, and their number */
+  struct SymTable_Gathered *bindings;
+  size_t length;
+  /* Number of characters in all the keys, with their nul characters */
+  size_t keysLength;
+};
+
+/* Add the binding of pcKey to pvValue to the SymTable_Gathering
+   pvGathering. */
+static void SymTable_gather(const char *pcKey, void *pvValue, void *pvGathering)
+{
+  struct SymTable_Gathering *gathering = pvGathering;
+
+  gathering->bindings[gathering->length].key = pcKey;
+  gathering->bindings[gathering->length].value = pvValue;
+  gathering->length++;
+  gathering->keysLength += strlen(pcKey) + 1;
+}
+
+/* A bucket of keys that SymTable_freeze must find a pilot for */
+struct SymTable_FreezeBucket
+{
+  /* Number of keys in the bucket */
+  size_t size;
+  /* Index of the bucket */
+  size_t index;
+};
+
+/* Compare the SymTable_FreezeBuckets at pvFirst and pvSecond, so that
+   larger buckets sort first. */
+static int SymTable_compareBuckets(const void *pvFirst, const void *pvSecond)
+{
+  const struct SymTable_FreezeBucket *first = pvFirst;
+  const struct SymTable_FreezeBucket *second = pvSecond;
+
+  if (first->size != second->size)
+  {
+    return first->size > second->size ? -1 : 1;
+  }
+  return first->index < second->index ? -1 : first->index > second->index;
+}
+
+/* SymTable_findPilot looks for a pilot that sends each of the uSize keys
+whose hashes are in auHashes to a slot, among uLength slots, that is
+free in acTaken and that no other of the keys is sent to. It stores
+the slots in auSlots and returns 1, or returns 0 if no such pilot is
+found among the first PILOT_TRIES * uLength + PILOT_TRIES_MIN. */
+static int SymTable_findPilot(const size_t auHashes[], size_t uSize, size_t uLength, const unsigned char acTaken[], size_t auSlots[], uint32_t *puPilot)
+{
+  uint32_t pilot;
+  uint32_t tries = UINT32_MAX;
+  size_t i;
+  size_t j;
+
+  /* keys with equal hashes go to the same slot under every pilot */
+  for (i = 0; i < uSize; i++)
+  {
+    for (j = 0; j < i; j++)
+    {
+      if (auHashes[i] == auHashes[j])
+      {
+        return 0;
+      }
+    }
+  }
+
+  if (uLength < (UINT32_MAX - PILOT_TRIES_MIN) / PILOT_TRIES)
+  {
+    tries = (uint32_t)(PILOT_TRIES * uLength + PILOT_TRIES_MIN);
+  }
+
+  for (pilot = 0; pilot < tries; pilot++)
+  {
+    for (i = 0; i < uSize; i++)
+    {
+      auSlots[i] = SymTable_frozenSlot(auHashes[i], pilot, uLength);
+      if (acTaken[auSlots[i]])
+      {
+        break;
+      }
+      for (j = 0; j < i && auSlots[j] != auSlots[i]; j++)
+      {
+      }
+      if (j < i)
+      {
+        break;
+      }
+    }
+    if (i == uSize)
+    {
+      *puPilot = pilot;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* SymTable_placeFrozen finds, for the gathered bindings in gathering
+whose keys *pfHash hashes with uSeed to the hashes it stores in
+auHashes, a pilot for each
+of the uNumOfBuckets buckets of a frozen table, storing them in
+auPilots, and stores the slot of each binding in auSlots. It returns 1,
+or 0 if there is insufficient memory or no pilot can be found for some
+bucket. */
+static int SymTable_placeFrozen(const struct SymTable_Gathering *gathering, SymTable_HashFunction pfHash, size_t uSeed, size_t auHashes[], size_t uNumOfBuckets, uint32_t auPilots[], size_t auSlots[])
+{
+  struct SymTable_FreezeBucket *order;
+  size_t *starts;
+  size_t *members;
+  size_t *memberHashes;
+  size_t *memberSlots;
+  unsigned char *taken;
+  size_t length = gathering->length;
+  size_t bucket;
+  size_t size;
+  size_t i;
+  size_t j;
+  int ok = 1;
+
+  for (i = 0; i < length; i++)
+  {
+    auHashes[i] = (*pfHash)(gathering->bindings[i].key, uSeed);
+  }
+
+  /* the members of bucket b are members[starts[b]] up to but not
+     including members[starts[b + 1]] */
+  order = malloc(uNumOfBuckets * sizeof(struct SymTable_FreezeBucket));
+  starts = calloc(uNumOfBuckets + 1, sizeof(size_t));
+  members = malloc((length + 1) * sizeof(size_t));
+  memberHashes = malloc((length + 1) * sizeof(size_t));
+  memberSlots = malloc((length + 1) * sizeof(size_t));
+  taken = calloc(length + 1, 1);
+  if (order == NULL || starts == NULL || members == NULL
+      || memberHashes == NULL || memberSlots == NULL || taken == NULL)
+  {
+    free(taken);
+    free(memberSlots);
+    free(memberHashes);
+    free(members);
+    free(starts);
+    free(order);
+    return 0;
+  }
+
+  for (i = 0; i < length; i++)
+  {
+    starts[SymTable_frozenBucket(auHashes[i], uNumOfBuckets) + 1]++;
+  }
+  for (bucket = 0; bucket < uNumOfBuckets; bucket++)
+  {
+    order[bucket].size = starts[bucket + 1];
+    order[bucket].index = bucket;
+    starts[bucket + 1] += starts[bucket];
+  }
+  /* filling each bucket advances its start to the next bucket's */
+  for (i = 0; i < length; i++)
+  {
+    members[starts[SymTable_frozenBucket(auHashes[i], uNumOfBuckets)]++] = i;
+  }
+  for (bucket = uNumOfBuckets; bucket > 0; bucket--)
+  {
+    starts[bucket] = starts[bucket - 1];
+  }
+  starts[0] = 0;
+
+  /* the largest buckets are placed first, while most slots are free,
+     which keeps the search for their pilots short */
+  qsort(order, uNumOfBuckets, sizeof(struct SymTable_FreezeBucket),
+        SymTable_compareBuckets);
+  for (i = 0; i < uNumOfBuckets && ok; i++)
+  {
+    bucket = order[i].index;
+    size = order[i].size;
+    auPilots[bucket] = 0;
+    if (size == 0)
+    {
+      continue;
+    }
+    for (j = 0; j < size; j++)
+    {
+      memberHashes[j] = auHashes[members[starts[bucket] + j]];
+    }
+    ok = SymTable_findPilot(memberHashes, size, length, taken, memberSlots,
+                            &auPilots[bucket]);
+    for (j = 0; j < size && ok; j++)
+    {
+      taken[memberSlots[j]] = 1;
+      auSlots[members[starts[bucket] + j]] = memberSlots[j];
+    }
+  }
+
+  free(taken);
+  free(memberSlots);
+  free(memberHashes);
+  free(members);
+  free(starts);
+  free(order);
+  return ok;
+}
+
+int SymTable_freeze(SymTable_T oSymTable)
+{
+  struct SymTable_Gathering gathering;
+  struct SymTable_Frozen *frozen;
+  SymTable_HashFunction hashFunction;
+  size_t seed;
+  size_t *hashes;
+  size_t *slots;
+  size_t numOfSlots;
+  size_t offset;
+  size_t attempt;
+  size_t i;
+  int ok = 0;
+
+  assert(oSymTable != NULL);
+  /* the values of an image would be unmapped with it */
+  assert(oSymTable->image == NULL);
+
+  if (oSymTable->frozen != NULL)
+  {
+    return 1;
+  }
+  hashFunction = oSymTable->hashFunction;
+  seed = oSymTable->seed;
+
+  /* an empty table still gets one slot, so that no allocation has
+     zero bytes */
+  numOfSlots = oSymTable->length == 0 ? 1 : oSymTable->length;
+  gathering.bindings = malloc(numOfSlots * sizeof(struct SymTable_Gathered));
+  hashes = malloc(numOfSlots * sizeof(size_t));
+  slots = malloc(numOfSlots * sizeof(size_t));
+  frozen = malloc(sizeof(struct SymTable_Frozen));
+  if (frozen != NULL)
+  {
+    frozen->numOfBuckets = oSymTable->length / FROZEN_BUCKET_SIZE + 1;
+    frozen->pilots = malloc(frozen->numOfBuckets * sizeof(uint32_t));
+    frozen->keyOffsets = malloc(numOfSlots * sizeof(uint32_t));
+    frozen->values = malloc(numOfSlots * sizeof(void*));
+    frozen->keys = NULL;
+  }
+  if (gathering.bindings != NULL && hashes != NULL && slots != NULL
+      && frozen != NULL && frozen->pilots != NULL
+      && frozen->keyOffsets != NULL && frozen->values != NULL)
+  {
+    gathering.length = 0;
+    gathering.keysLength = 0;
+    SymTable_map(oSymTable, SymTable_gather, &gathering);
+    /* every key must start at an offset that fits in 32 bits */
+    if (gathering.keysLength < UINT32_MAX)
+    {
+      frozen->keys = malloc(gathering.keysLength + 1);
+    }
+    ok = frozen->keys != NULL;
+  }
+
+  /* the table's own hash function is tried first, since it may well
+     be faster than SymTable_hashWord. It fails only if keys of one
+     bucket hash alike, and then another seed almost always succeeds. */
+  for (attempt = 0; ok && attempt < FREEZE_ATTEMPTS; attempt++)
+  {
+    if (attempt > 0)
+    {
+      hashFunction = SymTable_hashWord;
+      seed = SymTable_randomSeed();
+    }
+    if (SymTable_placeFrozen(&gathering, hashFunction, seed, hashes,
+                             frozen->numOfBuckets, frozen->pilots, slots))
+    {
+      break;
+    }
+  }
+  ok = ok && attempt < FREEZE_ATTEMPTS;
+
+  if (! ok)
+  {
+    free(hashes);
+    free(slots);
+    free(gathering.bindings);
+    if (frozen != NULL)
+    {
+      free(frozen->keys);
+      free(frozen->values);
+      free(frozen->keyOffsets);
+      free(frozen->pilots);
+      free(frozen);
+    }
+    return 0;
+  }
+
+  /* the hashes are done with, so they record which binding each slot
+     holds, and the keys are copied in slot order */
+  for (i = 0; i < gathering.length; i++)
+  {
+    hashes[slots[i]] = i;
+  }
+  offset = 0;
+  for (i = 0; i < gathering.length; i++)
+  {
+    frozen->keyOffsets[i] = (uint32_t)offset;
+    frozen->values[i] = gathering.bindings[hashes[i]].value;
+    strcpy(frozen->keys + offset, gathering.bindings[hashes[i]].key);
+    offset += strlen(frozen->keys + offset) + 1;
+  }
+  free(hashes);
+  free(slots);
+  free(gathering.bindings);
+
+  /* the frozen table owns copies of the keys, so the table's own
+     bindings can all go */
+  SymTable_clear(oSymTable);
+  SymTable_init(oSymTable, hashFunction, seed);
+  oSymTable->length = gathering.length;
+  oSymTable->frozen = frozen;
+  return 1;
 }
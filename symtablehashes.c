@@ -0,0 +1,106 @@
+/* This code implements the hash functions that symtable.h provides for SymTable_newWithHash, along with a source of random seeds for them. */
+
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include "symtable.h"
+
+/* Multipliers for SymTable_hashWord, taken from xxHash64 */
+static const uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+static const uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+
+/* Return u rotated left by iBits, which must be between 1 and 63. */
+static uint64_t SymTable_rotl(uint64_t u, int iBits)
+{
+  return (u << iBits) | (u >> (64 - iBits));
+}
+
+/* Return the 8 bytes at pcBytes as one word. memcpy keeps the read
+   legal at any alignment and compiles to a single load. */
+static uint64_t SymTable_readWord(const char *pcBytes)
+{
+  uint64_t uWord;
+
+  memcpy(&uWord, pcBytes, sizeof(uWord));
+  return uWord;
+}
+
+size_t SymTable_hashPolynomial(const char *pcKey, size_t uSeed)
+{
+   const size_t HASH_MULTIPLIER = 65599;
+   size_t u;
+   size_t uHash = uSeed;
+
+   assert(pcKey != NULL);
+
+   for (u = 0; pcKey[u] != '\0'; u++)
+      uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+
+   return uHash;
+}
+
+size_t SymTable_hashWord(const char *pcKey, size_t uSeed)
+{
+  uint64_t hash;
+  uint64_t tail;
+  size_t length;
+  size_t i;
+
+  assert(pcKey != NULL);
+
+  length = strlen(pcKey);
+  hash = (uint64_t)uSeed + PRIME4 + (uint64_t)length * PRIME1;
+
+  /* mix in the key eight bytes at a time */
+  for (i = 0; i + 8 <= length; i += 8)
+  {
+    hash ^= SymTable_rotl(SymTable_readWord(pcKey + i) * PRIME2, 31) * PRIME1;
+    hash = SymTable_rotl(hash, 27) * PRIME1 + PRIME4;
+  }
+
+  /* mix in the last partial word, zero padded */
+  if (i < length)
+  {
+    tail = 0;
+    memcpy(&tail, pcKey + i, length - i);
+    hash ^= SymTable_rotl(tail * PRIME2, 31) * PRIME1;
+    hash = SymTable_rotl(hash, 23) * PRIME2 + PRIME3;
+  }
+
+  /* avalanche so that every input bit affects the low bits */
+  hash ^= hash >> 33;
+  hash *= PRIME2;
+  hash ^= hash >> 29;
+  hash *= PRIME3;
+  hash ^= hash >> 32;
+  return (size_t)hash;
+}
+
+size_t SymTable_randomSeed(void)
+{
+  static size_t uCounter = 0;
+  size_t uSeed = 0;
+  FILE *psFile;
+
+  psFile = fopen("/dev/urandom", "rb");
+  if (psFile != NULL)
+  {
+    if (fread(&uSeed, sizeof(uSeed), 1, psFile) != 1)
+    {
+      uSeed = 0;
+    }
+    fclose(psFile);
+  }
+
+  /* Without /dev/urandom, fall back on values that differ between
+     processes and between calls. Hashing them spreads the few bits
+     that change across the whole seed. */
+  uCounter++;
+  uSeed ^= (size_t)time(NULL) ^ ((size_t)clock() << 16)
+    ^ (size_t)(uintptr_t)&uCounter ^ (uCounter * (size_t)PRIME1);
+  return SymTable_hashWord("", uSeed);
+}
@@ -4,17 +4,20 @@
 #include <string.h>
 #include <stdlib.h>
 #include "symtable.h"
+#include "symtablearena.h"
 
 /* Each key-value binding pair is stored in a SymTableNode structure.
  Nodes are linked with pointers to form a linked list. */
 struct SymTableNode
 {
-  /* Constant char pointer contains key */
-  const char *key;
   /* Constant void pointer contains value */
   void *value;
+  /* Hash code of key, compared before key in hashed lookups */
+  size_t hash;
   /* Structure points to next SymTableNode structure in linked list */
   struct SymTableNode *next;
+  /* Key bytes trail the node in the same allocation */
+  char key[];
 };
 
 /* SymTable structure begins linked list */
@@ -24,11 +27,24 @@ struct SymTable
   struct SymTableNode *first;
   /* Length of linked list */
   size_t length;
+  /* Arena that holds every SymTableNode */
+  SymTableArena_T arena;
+  /* Function that hashes keys, and the seed it is given */
+  SymTable_HashFunction hashFunction;
+  size_t seed;
 };
 
 SymTable_T SymTable_new(void)
+{
+  return SymTable_newWithHash(SymTable_hashPolynomial, 0);
+}
+
+SymTable_T SymTable_newWithHash(SymTable_HashFunction pfHash, size_t uSeed)
 {
   SymTable_T oSymTable;
+
+  assert(pfHash != NULL);
+
   oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
   if (oSymTable == NULL)
   {
@@ -36,25 +52,23 @@ SymTable_T SymTable_new(void)
   }
   oSymTable->length = 0;
   oSymTable->first = NULL;
+  oSymTable->hashFunction = pfHash;
+  oSymTable->seed = uSeed;
+  oSymTable->arena = SymTableArena_new();
+  if (oSymTable->arena == NULL)
+  {
+    free(oSymTable);
+    return NULL;
+  }
   return oSymTable;
 }
 
 void SymTable_free(SymTable_T oSymTable)
 {
-  struct SymTableNode *current;
-  struct SymTableNode *forward;
-  
   assert(oSymTable != NULL);
 
-  for (current = oSymTable->first;
-       current != NULL;
-       current = forward)
-  {
-    forward = current->next;
-    free((void*) current->key);
-    free(current);
-  }
-
+  /* every node lives in the arena, so the list need not be walked */
+  SymTableArena_free(oSymTable->arena);
   free(oSymTable);
     
 }
@@ -68,32 +82,35 @@ size_t SymTable_getLength(SymTable_T oSymTable)
   
 }
 
+SymTable_Key SymTable_hashKey(SymTable_T oSymTable, const char *pcKey)
+{
+  SymTable_Key oKey;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  oKey.hash = (*oSymTable->hashFunction)(pcKey, oSymTable->seed);
+  oKey.length = strlen(pcKey);
+  return oKey;
+}
+
 int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue)
+{
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  return SymTable_putHashed(oSymTable, pcKey, SymTable_hashKey(oSymTable, pcKey), pvValue);
+}
+
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey, SymTable_Key oKey, const void *pvValue)
 {
   struct SymTableNode *current;
   struct SymTableNode *forward;
   struct SymTableNode *newNode;
-  char *defCopyofKey;
     
   assert(oSymTable != NULL);
   assert(pcKey != NULL);
 
-  /* allocate memory for newNode structure */
-  newNode = malloc(sizeof(struct SymTableNode));
-  if (newNode == NULL)
-  {
-    return 0;
-  }
-
-  /* create defensive copy */
-  defCopyofKey = (char*)malloc(strlen(pcKey) + 1);
-  if (defCopyofKey == NULL)
-  {
-    free(newNode);
-    return 0;
-  }
-  strcpy(defCopyofKey, pcKey);
-
   /* search SymTable_T structure to see if there are any
  bindings with keys that are the same as pcKey */
   
@@ -101,18 +118,25 @@ int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue)
        current != NULL;
        current = forward)
   {
-    if(strcmp(current->key, defCopyofKey) == 0)
+    if(current->hash == oKey.hash && strcmp(current->key, pcKey) == 0)
     {
-      free(defCopyofKey);
-      free(newNode);
       return 0;
     }
     forward = current->next;
   }
 
+  /* allocate memory for newNode structure and its defensive copy of
+     pcKey together, now that the binding is known to be new */
+  newNode = SymTableArena_alloc(oSymTable->arena, sizeof(struct SymTableNode) + oKey.length + 1);
+  if (newNode == NULL)
+  {
+    return 0;
+  }
+  memcpy(newNode->key, pcKey, oKey.length + 1);
+
   /* add new node to the front of the linked list */     
-  newNode->key = defCopyofKey;
   newNode->value = (void*) pvValue;
+  newNode->hash = oKey.hash;
   newNode->next = oSymTable->first;
   oSymTable->first = newNode;
   oSymTable->length++;
@@ -125,19 +149,10 @@ void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvVa
   struct SymTableNode *current;
   struct SymTableNode *forward;
   void *oldVal;
-  char *defCopyofKey;
 
   assert(oSymTable != NULL);
   assert(pcKey != NULL);
 
-  /* create defensive copy */
-  defCopyofKey = malloc(strlen(pcKey) + 1);
-  if (defCopyofKey == NULL)
-  {
-    return 0;
-  }
-  strcpy(defCopyofKey, pcKey);
-
   /* Search SymTable_T structure to see if
  it has a binding with a key matching pcKey.
  If it does, change the value of that SymTableNode to pvValue.
@@ -146,9 +161,8 @@ void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvVa
        current != NULL;
        current = forward)
   {
-    if (strcmp(current->key, defCopyofKey) == 0)
+    if (strcmp(current->key, pcKey) == 0)
     {
-      free(defCopyofKey);
       oldVal = current->value;
       current->value = (void*) pvValue;
       return oldVal;
@@ -156,7 +170,6 @@ void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvVa
     forward = current->next;
   }
 
-  free(defCopyofKey);
   return NULL;
 
 }
@@ -165,34 +178,23 @@ int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
 {
   struct SymTableNode *current;
   struct SymTableNode *forward;
-  char *defCopyofKey;
   
   assert(oSymTable != NULL);
   assert(pcKey != NULL);
 
-  /* create defensive copy */
-  defCopyofKey = malloc(strlen(pcKey) + 1);
-  if (defCopyofKey == NULL)
-  {
-    return 0;
-  }
-  strcpy(defCopyofKey, pcKey);
-
   /* search SymTable_T structure for any key-value pairs that have the key pcKey.
  If there is a match, return 1. If not, return 0 */
   for (current = oSymTable->first;
        current != NULL;
        current = forward)
   {
-    if(strcmp(current->key, defCopyofKey) == 0)
+    if(strcmp(current->key, pcKey) == 0)
     {
-      free(defCopyofKey);
       return 1;
     }
     forward = current->next;
   }
 
-  free(defCopyofKey);
   return 0;
   
 }
@@ -201,35 +203,47 @@ void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
 {
   struct SymTableNode *current;
   struct SymTableNode *forward;
-  char *defCopyofKey;
   void *foundVal;
     
   assert(oSymTable != NULL);
   assert(pcKey != NULL);
 
-  /* create defensive copy */
-  defCopyofKey = malloc(strlen(pcKey) + 1);
-  if (defCopyofKey == NULL)
-  {
-    return 0;
-  }
-  strcpy(defCopyofKey, pcKey);
-
   /* Search SymTable_T structure for any bindings with pcKey as the key.
      If there is a binding with pcKey, the value of that binding is returned. If not, NULL is returned. */  
   for (current = oSymTable->first;
        current != NULL;
        current = forward)
   {
-    if(strcmp(current->key, defCopyofKey) == 0)
+    if(strcmp(current->key, pcKey) == 0)
     {
-      free(defCopyofKey);
       foundVal = current->value;
       return foundVal;
     }
     forward = current->next;
   }
-  free(defCopyofKey);
+  return NULL;
+}
+
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey, SymTable_Key oKey)
+{
+  struct SymTableNode *current;
+  struct SymTableNode *forward;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  /* Search as SymTable_get does, but let the hash code rule out
+     most bindings before comparing keys. */
+  for (current = oSymTable->first;
+       current != NULL;
+       current = forward)
+  {
+    if(current->hash == oKey.hash && strcmp(current->key, pcKey) == 0)
+    {
+      return current->value;
+    }
+    forward = current->next;
+  }
   return NULL;
 }
 
@@ -239,7 +253,6 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
  struct SymTableNode *previous;
  struct SymTableNode *current;
  struct SymTableNode *forward;
- char *defCopyofKey;
 
  assert(oSymTable != NULL);
  assert(pcKey != NULL);
@@ -250,22 +263,13 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
    return NULL;
  }
  
- /* create defensive copy */
- defCopyofKey = (char*)malloc(strlen(pcKey) + 1);
- if (defCopyofKey == NULL)
- {
-   return 0;
- }
- strcpy(defCopyofKey, pcKey);
-
  /* Base Case: if SymTable_T structure has only one SymTableNode */
- if(strcmp(oSymTable->first->key, defCopyofKey) == 0)
+ if(strcmp(oSymTable->first->key, pcKey) == 0)
  {
-   free(defCopyofKey);
    holdVal = oSymTable->first->value;
    forward = oSymTable->first->next;
-   free((void*) oSymTable->first->key);
-   free(oSymTable->first);
+   SymTableArena_release(oSymTable->arena, oSymTable->first,
+                         sizeof(struct SymTableNode) + strlen(oSymTable->first->key) + 1);
    oSymTable->first = forward;
    oSymTable->length--;
    return (void*) holdVal;
@@ -280,14 +284,13 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
       current != NULL;
       current = forward)
    {
-     if(strcmp(current->key, defCopyofKey) == 0)
+     if(strcmp(current->key, pcKey) == 0)
      {
-       free(defCopyofKey);
        holdVal = current->value;
        forward = current->next;
        previous->next = forward;
-       free((void*) current->key);
-       free(current);
+       SymTableArena_release(oSymTable->arena, current,
+                             sizeof(struct SymTableNode) + strlen(current->key) + 1);
        oSymTable->length--;
        return (void*) holdVal;
      }
@@ -295,11 +298,82 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
      previous = current;
    }
 
- free(defCopyofKey);
  return NULL;
  
 }
 
+void *SymTable_removeHashed(SymTable_T oSymTable, const char *pcKey, SymTable_Key oKey)
+{
+ const void *holdVal;
+ struct SymTableNode **previous;
+ struct SymTableNode *current;
+
+ assert(oSymTable != NULL);
+ assert(pcKey != NULL);
+
+ /* Unlink the SymTableNode whose key matches pcKey and return its
+ value, comparing hash codes before keys. Otherwise, NULL is returned. */
+ for (previous = &oSymTable->first;
+      *previous != NULL;
+      previous = &current->next)
+ {
+   current = *previous;
+   if(current->hash == oKey.hash && strcmp(current->key, pcKey) == 0)
+   {
+     holdVal = current->value;
+     *previous = current->next;
+     SymTableArena_release(oSymTable->arena, current,
+                           sizeof(struct SymTableNode) + oKey.length + 1);
+     oSymTable->length--;
+     return (void*) holdVal;
+   }
+ }
+
+ return NULL;
+}
+
+int SymTable_begin(SymTable_T oSymTable, SymTable_Iterator *poIterator)
+{
+  assert(oSymTable != NULL);
+  assert(poIterator != NULL);
+
+  poIterator->node = oSymTable->first;
+  poIterator->bucket = 0;
+  return poIterator->node != NULL;
+}
+
+int SymTable_next(SymTable_T oSymTable, SymTable_Iterator *poIterator)
+{
+  struct SymTableNode *current;
+
+  assert(oSymTable != NULL);
+  assert(poIterator != NULL);
+
+  current = poIterator->node;
+  if (current == NULL)
+  {
+    return 0;
+  }
+  poIterator->node = current->next;
+  return poIterator->node != NULL;
+}
+
+const char *SymTable_key(const SymTable_Iterator *poIterator)
+{
+  assert(poIterator != NULL);
+  assert(poIterator->node != NULL);
+
+  return ((struct SymTableNode*)poIterator->node)->key;
+}
+
+void *SymTable_value(const SymTable_Iterator *poIterator)
+{
+  assert(poIterator != NULL);
+  assert(poIterator->node != NULL);
+
+  return ((struct SymTableNode*)poIterator->node)->value;
+}
+
 void SymTable_map(SymTable_T  oSymTable, void(*pfApply)(const char *pcKey, void *pvValue, void *pvExtra), const void *pvExtra)
 {
  struct SymTableNode *current;
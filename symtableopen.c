@@ -0,0 +1,341 @@
+/* This code implements a symbol table using an open addressing hash table with Robin Hood displacement. Bindings live directly in one array of slots, so a lookup walks consecutive slots instead of chasing a pointer per binding. */
+
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+#include "symtable.h"
+
+/* Number of slots in a new SymTable. Always a power of two. */
+enum {INITIAL_CAPACITY = 16};
+
+/* The table doubles once more than MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR
+ of its slots would be occupied. */
+enum {MAX_LOAD_NUMERATOR = 7, MAX_LOAD_DENOMINATOR = 8};
+
+/* Each key-value binding pair is stored in a SymTable_Slot structure.
+ A slot whose key is NULL is empty. */
+struct SymTable_Slot
+{
+  /* Keys stored in constant char pointer. */
+  const char *key;
+  /* Values stored in void pointer. */
+  void *value;
+  /* Full hash of key, so probing and growing never rehash the key. */
+  size_t hash;
+};
+
+/* Begins open addressing hash table */
+struct SymTable
+{
+  /* Number of bindings is the length */
+  size_t length;
+  /* Array of slots holding the bindings */
+  struct SymTable_Slot *slots;
+  /* Number of slots, a power of two */
+  size_t capacity;
+};
+
+/* Return a hash code for pcKey. The 65599 polynomial is followed by a
+   finalizer because slots are indexed by the low bits of the hash. */
+static size_t SymTable_hash(const char *pcKey)
+{
+   const size_t HASH_MULTIPLIER = 65599;
+   size_t u;
+   size_t uHash = 0;
+
+   assert(pcKey != NULL);
+
+   for (u = 0; pcKey[u] != '\0'; u++)
+      uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+
+   uHash ^= uHash >> 15;
+   uHash *= (size_t)0x2c1b3c6dU;
+   uHash ^= uHash >> 12;
+   uHash *= (size_t)0x297a2d39U;
+   uHash ^= uHash >> 15;
+   return uHash;
+}
+
+/* Return how many slots past its home slot the binding in slot uIndex
+   of oSymTable sits. */
+static size_t SymTable_distance(SymTable_T oSymTable, size_t uIndex)
+{
+  size_t mask = oSymTable->capacity - 1;
+
+  return (uIndex - (oSymTable->slots[uIndex].hash & mask)) & mask;
+}
+
+/* SymTable_find returns the index of the slot of oSymTable whose key is
+pcKey and whose hash is uHash, or oSymTable->capacity if there is no
+such slot. Probing stops early at a binding closer to its home slot
+than pcKey would be, since Robin Hood insertion would have placed pcKey
+before it. */
+static size_t SymTable_find(SymTable_T oSymTable, const char *pcKey, size_t uHash)
+{
+  size_t mask = oSymTable->capacity - 1;
+  size_t index = uHash & mask;
+  size_t dist;
+  struct SymTable_Slot *slot;
+
+  for (dist = 0; ; dist++)
+  {
+    slot = &oSymTable->slots[index];
+    if (slot->key == NULL || SymTable_distance(oSymTable, index) < dist)
+    {
+      return oSymTable->capacity;
+    }
+    if (slot->hash == uHash && strcmp(slot->key, pcKey) == 0)
+    {
+      return index;
+    }
+    index = (index + 1) & mask;
+  }
+}
+
+/* SymTable_insert places the binding in carry into oSymTable, which must
+not contain its key and must have an empty slot. Richer bindings (those
+closer to their home slot) are displaced to make room for poorer ones. */
+static void SymTable_insert(SymTable_T oSymTable, struct SymTable_Slot carry)
+{
+  size_t mask = oSymTable->capacity - 1;
+  size_t index = carry.hash & mask;
+  size_t dist = 0;
+  size_t slotDist;
+  struct SymTable_Slot hold;
+
+  while (oSymTable->slots[index].key != NULL)
+  {
+    slotDist = SymTable_distance(oSymTable, index);
+    if (slotDist < dist)
+    {
+      hold = oSymTable->slots[index];
+      oSymTable->slots[index] = carry;
+      carry = hold;
+      dist = slotDist;
+    }
+    index = (index + 1) & mask;
+    dist++;
+  }
+  oSymTable->slots[index] = carry;
+}
+
+/* SymTable_expand takes a SymTable_T type oSymTable and doubles its
+number of slots, reinserting every binding by its stored hash. If there
+is insufficient memory, it returns 0 and leaves oSymTable unchanged.
+Otherwise it returns 1. */
+static int SymTable_expand(SymTable_T oSymTable)
+{
+  struct SymTable_Slot *oldSlots;
+  size_t oldCapacity;
+  size_t i;
+
+  assert(oSymTable != NULL);
+
+  oldSlots = oSymTable->slots;
+  oldCapacity = oSymTable->capacity;
+
+  oSymTable->slots = calloc(oldCapacity * 2, sizeof(struct SymTable_Slot));
+  if (oSymTable->slots == NULL)
+  {
+    oSymTable->slots = oldSlots;
+    return 0;
+  }
+  oSymTable->capacity = oldCapacity * 2;
+
+  for (i = 0; i < oldCapacity; i++)
+  {
+    if (oldSlots[i].key != NULL)
+    {
+      SymTable_insert(oSymTable, oldSlots[i]);
+    }
+  }
+
+  free(oldSlots);
+  return 1;
+}
+
+SymTable_T SymTable_new(void)
+{
+  SymTable_T oSymTable;
+
+  oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+  if (oSymTable == NULL)
+  {
+    return NULL;
+  }
+
+  oSymTable->length = 0;
+  oSymTable->capacity = INITIAL_CAPACITY;
+  oSymTable->slots = calloc(oSymTable->capacity, sizeof(struct SymTable_Slot));
+  if (oSymTable->slots == NULL)
+  {
+    free(oSymTable);
+    return NULL;
+  }
+
+  return oSymTable;
+}
+
+void SymTable_free(SymTable_T oSymTable)
+{
+  size_t i;
+
+  assert(oSymTable != NULL);
+
+  for (i = 0; i < oSymTable->capacity; i++)
+  {
+    free((void*) oSymTable->slots[i].key);
+  }
+
+  free(oSymTable->slots);
+  free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+  assert(oSymTable != NULL);
+
+  return oSymTable->length;
+}
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue)
+{
+  struct SymTable_Slot carry;
+  char *defCopyofKey;
+  size_t hash;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  hash = SymTable_hash(pcKey);
+  if (SymTable_find(oSymTable, pcKey, hash) != oSymTable->capacity)
+  {
+    return 0;
+  }
+
+  /* expansion check: a failed expansion is only fatal once no empty
+     slot would remain to end probe sequences */
+  if ((oSymTable->length + 1) * MAX_LOAD_DENOMINATOR
+      > oSymTable->capacity * MAX_LOAD_NUMERATOR)
+  {
+    if (! SymTable_expand(oSymTable)
+        && oSymTable->length + 1 >= oSymTable->capacity)
+    {
+      return 0;
+    }
+  }
+
+  /* create defensive copy */
+  defCopyofKey = (char*)malloc(strlen(pcKey) + 1);
+  if (defCopyofKey == NULL)
+  {
+    return 0;
+  }
+  strcpy(defCopyofKey, pcKey);
+
+  carry.key = defCopyofKey;
+  carry.value = (void*) pvValue;
+  carry.hash = hash;
+  SymTable_insert(oSymTable, carry);
+  oSymTable->length++;
+  return 1;
+}
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue)
+{
+  void *oldVal;
+  size_t index;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  index = SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey));
+  if (index == oSymTable->capacity)
+  {
+    return NULL;
+  }
+
+  oldVal = oSymTable->slots[index].value;
+  oSymTable->slots[index].value = (void*) pvValue;
+  return oldVal;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  return SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey))
+    != oSymTable->capacity;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+  size_t index;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  index = SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey));
+  if (index == oSymTable->capacity)
+  {
+    return NULL;
+  }
+  return oSymTable->slots[index].value;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+  void *holdVal;
+  size_t mask;
+  size_t index;
+  size_t forward;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  index = SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey));
+  if (index == oSymTable->capacity)
+  {
+    return NULL;
+  }
+
+  holdVal = oSymTable->slots[index].value;
+  free((void*) oSymTable->slots[index].key);
+
+  /* Backward-shift deletion: pull each following displaced binding one
+     slot closer to its home until an empty slot or a binding already
+     at its home slot is reached. No tombstones are left behind. */
+  mask = oSymTable->capacity - 1;
+  forward = (index + 1) & mask;
+  while (oSymTable->slots[forward].key != NULL
+         && SymTable_distance(oSymTable, forward) > 0)
+  {
+    oSymTable->slots[index] = oSymTable->slots[forward];
+    index = forward;
+    forward = (forward + 1) & mask;
+  }
+  oSymTable->slots[index].key = NULL;
+  oSymTable->slots[index].value = NULL;
+  oSymTable->slots[index].hash = 0;
+
+  oSymTable->length--;
+  return holdVal;
+}
+
+void SymTable_map(SymTable_T oSymTable, void(*pfApply)(const char *pcKey, void *pvValue, void *pvExtra), const void *pvExtra)
+{
+  size_t i;
+
+  assert(oSymTable != NULL);
+  assert(pfApply != NULL);
+
+  for (i = 0; i < oSymTable->capacity; i++)
+  {
+    if (oSymTable->slots[i].key != NULL)
+    {
+      (*pfApply)(oSymTable->slots[i].key, oSymTable->slots[i].value,
+                 (void*)pvExtra);
+    }
+  }
+}
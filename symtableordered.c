@@ -0,0 +1,360 @@
+/* This code implements a symbol table using a skip list, which keeps the bindings sorted by key. Each binding's node holds a tower of forward pointers whose height is chosen at random, so lookups, puts, and removes take O(log n) expected time, and SymTable_map, SymTable_mapRange, and SymTable_mapPrefix visit bindings in ascending key order. */
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include "symtable.h"
+#include "symtablearena.h"
+
+/* Maximum height of a tower. With BRANCHING, it covers 4 to the power
+ MAX_HEIGHT bindings before lookups slow down. */
+enum {MAX_HEIGHT = 24};
+
+/* Each level of a tower is present with probability 1 / BRANCHING of
+ the level below. Four keeps towers short, about 1.33 pointers per node
+ on average, so more of each node fits in the cache line it starts. */
+enum {BRANCHING = 4};
+
+/* Each key-value binding pair is stored in a SymTable_Node structure.
+ Nodes are linked at each level of the skip list in key order. */
+struct SymTable_Node
+{
+  /* Values stored in void pointer. */
+  void *value;
+  /* Number of levels at which the node is linked */
+  size_t height;
+  /* next[i] is the following node at level i. The key bytes trail the
+     tower in the same allocation. */
+  struct SymTable_Node *next[];
+};
+
+/* Begins skip list */
+struct SymTable
+{
+  /* Number of bindings is the length */
+  size_t length;
+  /* Sentinel node with a full tower and no key, before every binding */
+  struct SymTable_Node *head;
+  /* Number of levels at which some binding is linked */
+  size_t height;
+  /* State of the generator that chooses tower heights */
+  uint64_t random;
+  /* Arena that holds every SymTable_Node */
+  SymTableArena_T arena;
+};
+
+/* Return the key of node, which trails its tower. */
+static char *SymTable_nodeKey(struct SymTable_Node *node)
+{
+  return (char*)&node->next[node->height];
+}
+
+/* Return the size of a node whose tower has uHeight levels and whose
+   key has uKeyLength characters. */
+static size_t SymTable_nodeSize(size_t uHeight, size_t uKeyLength)
+{
+  return sizeof(struct SymTable_Node)
+    + uHeight * sizeof(struct SymTable_Node*) + uKeyLength + 1;
+}
+
+/* Return a random tower height for a new node of oSymTable, each
+   level present with probability 1 / BRANCHING of the one below. */
+static size_t SymTable_randomHeight(SymTable_T oSymTable)
+{
+  uint64_t bits;
+  size_t height = 1;
+
+  /* xorshift64 */
+  oSymTable->random ^= oSymTable->random << 13;
+  oSymTable->random ^= oSymTable->random >> 7;
+  oSymTable->random ^= oSymTable->random << 17;
+
+  for (bits = oSymTable->random; height < MAX_HEIGHT && bits % BRANCHING == 0;
+       bits /= BRANCHING)
+  {
+    height++;
+  }
+  return height;
+}
+
+/* SymTable_seek returns the first node of oSymTable whose key is not
+less than pcKey, or NULL if there is none. If ppsBefore is not NULL, it
+sets ppsBefore[i] to the last node before that one at level i, for each
+level up to MAX_HEIGHT. */
+static struct SymTable_Node *SymTable_seek(SymTable_T oSymTable, const char *pcKey, struct SymTable_Node *ppsBefore[])
+{
+  struct SymTable_Node *current = oSymTable->head;
+  struct SymTable_Node *forward;
+  size_t level;
+
+  for (level = MAX_HEIGHT; level > 0; level--)
+  {
+    /* levels above the tallest tower hold nothing */
+    if (level <= oSymTable->height)
+    {
+      for (forward = current->next[level - 1];
+           forward != NULL && strcmp(SymTable_nodeKey(forward), pcKey) < 0;
+           forward = current->next[level - 1])
+      {
+        current = forward;
+      }
+    }
+    if (ppsBefore != NULL)
+    {
+      ppsBefore[level - 1] = current;
+    }
+  }
+  return current->next[0];
+}
+
+/* SymTable_find returns the node of oSymTable whose key is pcKey, or
+NULL if there is no such node. */
+static struct SymTable_Node *SymTable_find(SymTable_T oSymTable, const char *pcKey)
+{
+  struct SymTable_Node *found;
+
+  found = SymTable_seek(oSymTable, pcKey, NULL);
+  if (found != NULL && strcmp(SymTable_nodeKey(found), pcKey) == 0)
+  {
+    return found;
+  }
+  return NULL;
+}
+
+SymTable_T SymTable_new(void)
+{
+  SymTable_T oSymTable;
+  size_t i;
+
+  oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+  if (oSymTable == NULL)
+  {
+    return NULL;
+  }
+
+  oSymTable->arena = SymTableArena_new();
+  if (oSymTable->arena == NULL)
+  {
+    free(oSymTable);
+    return NULL;
+  }
+
+  oSymTable->head = SymTableArena_alloc(oSymTable->arena,
+                                        SymTable_nodeSize(MAX_HEIGHT, 0));
+  if (oSymTable->head == NULL)
+  {
+    SymTableArena_free(oSymTable->arena);
+    free(oSymTable);
+    return NULL;
+  }
+  oSymTable->head->value = NULL;
+  oSymTable->head->height = MAX_HEIGHT;
+  for (i = 0; i < MAX_HEIGHT; i++)
+  {
+    oSymTable->head->next[i] = NULL;
+  }
+  SymTable_nodeKey(oSymTable->head)[0] = '\0';
+
+  oSymTable->length = 0;
+  oSymTable->height = 1;
+  oSymTable->random = 0x9E3779B97F4A7C15ULL;
+  return oSymTable;
+}
+
+void SymTable_free(SymTable_T oSymTable)
+{
+  assert(oSymTable != NULL);
+
+  /* every node, including the head, lives in the arena */
+  SymTableArena_free(oSymTable->arena);
+  free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+  assert(oSymTable != NULL);
+
+  return oSymTable->length;
+}
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue)
+{
+  struct SymTable_Node *before[MAX_HEIGHT];
+  struct SymTable_Node *found;
+  struct SymTable_Node *newNode;
+  size_t keyLength;
+  size_t height;
+  size_t i;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  found = SymTable_seek(oSymTable, pcKey, before);
+  if (found != NULL && strcmp(SymTable_nodeKey(found), pcKey) == 0)
+  {
+    return 0;
+  }
+
+  keyLength = strlen(pcKey);
+  height = SymTable_randomHeight(oSymTable);
+  newNode = SymTableArena_alloc(oSymTable->arena,
+                                SymTable_nodeSize(height, keyLength));
+  if (newNode == NULL)
+  {
+    return 0;
+  }
+  newNode->value = (void*) pvValue;
+  newNode->height = height;
+  memcpy(SymTable_nodeKey(newNode), pcKey, keyLength + 1);
+
+  /* before[i] is the head at each level above the old height */
+  for (i = 0; i < height; i++)
+  {
+    newNode->next[i] = before[i]->next[i];
+    before[i]->next[i] = newNode;
+  }
+  if (height > oSymTable->height)
+  {
+    oSymTable->height = height;
+  }
+
+  oSymTable->length++;
+  return 1;
+}
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue)
+{
+  struct SymTable_Node *found;
+  void *oldVal;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  found = SymTable_find(oSymTable, pcKey);
+  if (found == NULL)
+  {
+    return NULL;
+  }
+
+  oldVal = found->value;
+  found->value = (void*) pvValue;
+  return oldVal;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  return SymTable_find(oSymTable, pcKey) != NULL;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+  struct SymTable_Node *found;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  found = SymTable_find(oSymTable, pcKey);
+  if (found == NULL)
+  {
+    return NULL;
+  }
+  return found->value;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+  struct SymTable_Node *before[MAX_HEIGHT];
+  struct SymTable_Node *found;
+  void *holdVal;
+  size_t i;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  found = SymTable_seek(oSymTable, pcKey, before);
+  if (found == NULL || strcmp(SymTable_nodeKey(found), pcKey) != 0)
+  {
+    return NULL;
+  }
+
+  for (i = 0; i < found->height; i++)
+  {
+    before[i]->next[i] = found->next[i];
+  }
+  while (oSymTable->height > 1
+         && oSymTable->head->next[oSymTable->height - 1] == NULL)
+  {
+    oSymTable->height--;
+  }
+
+  holdVal = found->value;
+  SymTableArena_release(oSymTable->arena, found,
+                        SymTable_nodeSize(found->height,
+                                          strlen(SymTable_nodeKey(found))));
+  oSymTable->length--;
+  return holdVal;
+}
+
+void SymTable_map(SymTable_T oSymTable, void(*pfApply)(const char *pcKey, void *pvValue, void *pvExtra), const void *pvExtra)
+{
+  struct SymTable_Node *current;
+
+  assert(oSymTable != NULL);
+  assert(pfApply != NULL);
+
+  for (current = oSymTable->head->next[0]; current != NULL;
+       current = current->next[0])
+  {
+    (*pfApply)(SymTable_nodeKey(current), current->value, (void*)pvExtra);
+  }
+}
+
+void SymTable_mapRange(SymTable_T oSymTable, const char *pcLow, const char *pcHigh, void(*pfApply)(const char *pcKey, void *pvValue, void *pvExtra), const void *pvExtra)
+{
+  struct SymTable_Node *current;
+
+  assert(oSymTable != NULL);
+  assert(pfApply != NULL);
+
+  if (pcLow == NULL)
+  {
+    current = oSymTable->head->next[0];
+  }
+  else
+  {
+    current = SymTable_seek(oSymTable, pcLow, NULL);
+  }
+
+  for (; current != NULL; current = current->next[0])
+  {
+    if (pcHigh != NULL && strcmp(SymTable_nodeKey(current), pcHigh) >= 0)
+    {
+      break;
+    }
+    (*pfApply)(SymTable_nodeKey(current), current->value, (void*)pvExtra);
+  }
+}
+
+void SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix, void(*pfApply)(const char *pcKey, void *pvValue, void *pvExtra), const void *pvExtra)
+{
+  struct SymTable_Node *current;
+  size_t prefixLength;
+
+  assert(oSymTable != NULL);
+  assert(pcPrefix != NULL);
+  assert(pfApply != NULL);
+
+  /* the keys with a prefix are contiguous, starting at the prefix */
+  prefixLength = strlen(pcPrefix);
+  for (current = SymTable_seek(oSymTable, pcPrefix, NULL);
+       current != NULL
+         && strncmp(SymTable_nodeKey(current), pcPrefix, prefixLength) == 0;
+       current = current->next[0])
+  {
+    (*pfApply)(SymTable_nodeKey(current), current->value, (void*)pvExtra);
+  }
+}
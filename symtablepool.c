@@ -0,0 +1,251 @@
+/* This code implements a pool of interned strings as a hash set. Each distinct string is stored once, in an arena, together with its hash, length, and reference count, and the set doubles its bucket count whenever it holds more strings than buckets. */
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include "symtablepool.h"
+#include "symtablearena.h"
+
+/* A new pool starts with 2 to the power MIN_BUCKET_BITS buckets. */
+enum {MIN_BUCKET_BITS = 6};
+
+/* Each interned string is stored in a SymTablePool_String structure.
+ Strings whose hashes share a bucket are linked together. */
+struct SymTablePool_String
+{
+  /* Next string in the same bucket */
+  struct SymTablePool_String *next;
+  /* Full hash of the string */
+  size_t hash;
+  /* Number of characters in the string */
+  size_t length;
+  /* Number of references that SymTablePool_release has not returned */
+  size_t references;
+  /* Characters of the string, which SymTablePool_intern returns */
+  char bytes[];
+};
+
+/* Begins pool */
+struct SymTablePool
+{
+  /* Number of distinct strings */
+  size_t length;
+  /* Buckets, a power of two of them */
+  struct SymTablePool_String **buckets;
+  size_t numOfBuckets;
+  /* Seed given to SymTable_hashWord */
+  size_t seed;
+  /* Arena that holds every SymTablePool_String */
+  SymTableArena_T arena;
+};
+
+/* Return the SymTablePool_String whose characters begin at pcInterned. */
+static struct SymTablePool_String *SymTablePool_string(const char *pcInterned)
+{
+  return (struct SymTablePool_String*)
+    (pcInterned - offsetof(struct SymTablePool_String, bytes));
+}
+
+/* Return the size of the SymTablePool_String of a string of uLength
+   characters. */
+static size_t SymTablePool_stringSize(size_t uLength)
+{
+  return sizeof(struct SymTablePool_String) + uLength + 1;
+}
+
+/* SymTablePool_expand doubles the bucket count of oPool, relinking its
+strings. If there is insufficient memory, oPool is left unchanged. */
+static void SymTablePool_expand(SymTablePool_T oPool)
+{
+  struct SymTablePool_String **newBuckets;
+  struct SymTablePool_String *current;
+  struct SymTablePool_String *forward;
+  size_t newNumOfBuckets = oPool->numOfBuckets * 2;
+  size_t index;
+  size_t i;
+
+  newBuckets = calloc(newNumOfBuckets, sizeof(struct SymTablePool_String*));
+  if (newBuckets == NULL)
+  {
+    return;
+  }
+
+  for (i = 0; i < oPool->numOfBuckets; i++)
+  {
+    for (current = oPool->buckets[i]; current != NULL; current = forward)
+    {
+      forward = current->next;
+      index = current->hash & (newNumOfBuckets - 1);
+      current->next = newBuckets[index];
+      newBuckets[index] = current;
+    }
+  }
+
+  free(oPool->buckets);
+  oPool->buckets = newBuckets;
+  oPool->numOfBuckets = newNumOfBuckets;
+}
+
+SymTablePool_T SymTablePool_new(void)
+{
+  SymTablePool_T oPool;
+
+  oPool = (SymTablePool_T)malloc(sizeof(struct SymTablePool));
+  if (oPool == NULL)
+  {
+    return NULL;
+  }
+
+  oPool->numOfBuckets = (size_t)1 << MIN_BUCKET_BITS;
+  oPool->buckets = calloc(oPool->numOfBuckets, sizeof(struct SymTablePool_String*));
+  if (oPool->buckets == NULL)
+  {
+    free(oPool);
+    return NULL;
+  }
+
+  oPool->arena = SymTableArena_new();
+  if (oPool->arena == NULL)
+  {
+    free(oPool->buckets);
+    free(oPool);
+    return NULL;
+  }
+
+  oPool->length = 0;
+  oPool->seed = SymTable_randomSeed();
+  return oPool;
+}
+
+void SymTablePool_free(SymTablePool_T oPool)
+{
+  assert(oPool != NULL);
+
+  /* every string lives in the arena */
+  SymTableArena_free(oPool->arena);
+  free(oPool->buckets);
+  free(oPool);
+}
+
+size_t SymTablePool_getLength(SymTablePool_T oPool)
+{
+  assert(oPool != NULL);
+
+  return oPool->length;
+}
+
+size_t SymTablePool_seed(SymTablePool_T oPool)
+{
+  assert(oPool != NULL);
+
+  return oPool->seed;
+}
+
+SymTable_Key SymTablePool_hashKey(SymTablePool_T oPool, const char *pcString)
+{
+  SymTable_Key oKey;
+
+  assert(oPool != NULL);
+  assert(pcString != NULL);
+
+  oKey.hash = SymTable_hashWord(pcString, oPool->seed);
+  oKey.length = strlen(pcString);
+  return oKey;
+}
+
+SymTable_Key SymTablePool_keyOf(SymTablePool_T oPool, const char *pcInterned)
+{
+  struct SymTablePool_String *string;
+  SymTable_Key oKey;
+
+  assert(oPool != NULL);
+  assert(pcInterned != NULL);
+
+  string = SymTablePool_string(pcInterned);
+  assert(string->references > 0);
+  oKey.hash = string->hash;
+  oKey.length = string->length;
+  return oKey;
+}
+
+const char *SymTablePool_intern(SymTablePool_T oPool, const char *pcString)
+{
+  assert(oPool != NULL);
+  assert(pcString != NULL);
+
+  return SymTablePool_internHashed(oPool, pcString,
+                                   SymTablePool_hashKey(oPool, pcString));
+}
+
+const char *SymTablePool_internHashed(SymTablePool_T oPool, const char *pcString, SymTable_Key oKey)
+{
+  struct SymTablePool_String **bucket;
+  struct SymTablePool_String *current;
+
+  assert(oPool != NULL);
+  assert(pcString != NULL);
+
+  bucket = &oPool->buckets[oKey.hash & (oPool->numOfBuckets - 1)];
+  for (current = *bucket; current != NULL; current = current->next)
+  {
+    /* an interned string is its own copy */
+    if (current->hash == oKey.hash && current->length == oKey.length
+        && (current->bytes == pcString
+            || memcmp(current->bytes, pcString, oKey.length) == 0))
+    {
+      current->references++;
+      return current->bytes;
+    }
+  }
+
+  current = SymTableArena_alloc(oPool->arena,
+                                SymTablePool_stringSize(oKey.length));
+  if (current == NULL)
+  {
+    return NULL;
+  }
+  current->hash = oKey.hash;
+  current->length = oKey.length;
+  current->references = 1;
+  memcpy(current->bytes, pcString, oKey.length + 1);
+
+  /* expansion check: keep the load factor at or below one string
+     per bucket */
+  if (oPool->length >= oPool->numOfBuckets)
+  {
+    SymTablePool_expand(oPool);
+    bucket = &oPool->buckets[oKey.hash & (oPool->numOfBuckets - 1)];
+  }
+  current->next = *bucket;
+  *bucket = current;
+  oPool->length++;
+  return current->bytes;
+}
+
+void SymTablePool_release(SymTablePool_T oPool, const char *pcInterned)
+{
+  struct SymTablePool_String **previous;
+  struct SymTablePool_String *string;
+
+  assert(oPool != NULL);
+  assert(pcInterned != NULL);
+
+  string = SymTablePool_string(pcInterned);
+  assert(string->references > 0);
+  string->references--;
+  if (string->references > 0)
+  {
+    return;
+  }
+
+  for (previous = &oPool->buckets[string->hash & (oPool->numOfBuckets - 1)];
+       *previous != string;
+       previous = &(*previous)->next)
+  {
+  }
+  *previous = string->next;
+  SymTableArena_release(oPool->arena, string,
+                        SymTablePool_stringSize(string->length));
+  oPool->length--;
+}
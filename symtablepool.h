@@ -0,0 +1,40 @@
+/* Interface for symtablepool.c, a pool of interned keys that symtablehash.c tables created by SymTable_newWithPool share. */
+#include "symtable.h"
+#ifndef SYMTABLEPOOL_INCLUDED
+#define SYMTABLEPOOL_INCLUDED
+/* A SymTablePool_T, declared in symtable.h, holds one copy of each distinct string interned in it, with a count of references to the copy.
+ A pool hashes strings with SymTable_hashWord and its own random seed, so each distinct string is hashed once however many tables use it.
+ A pool may be used by only one thread at a time, along with every table created against it. */
+/* SymTablePool_new is a function that takes no arguments and
+returns a new SymTablePool_T holding no strings.
+If there is insufficient memory, it returns NULL. */
+SymTablePool_T SymTablePool_new(void);
+/* SymTablePool_free is a function that takes one argument,
+a SymTablePool_T type oPool, and frees all memory occupied by oPool, including every string interned in it.
+Every table created against oPool must be freed first. */
+void SymTablePool_free(SymTablePool_T oPool);
+/* SymTablePool_getLength is a function that takes one argument, a SymTablePool_T type oPool,
+ and returns the number of distinct strings interned in oPool. */
+size_t SymTablePool_getLength(SymTablePool_T oPool);
+/* SymTablePool_seed is a function that takes one argument, a SymTablePool_T type oPool,
+ and returns the seed with which oPool hashes strings. */
+size_t SymTablePool_seed(SymTablePool_T oPool);
+/* SymTablePool_intern is a function that takes two arguments, a SymTablePool_T type oPool and a constant char pointer pcString.
+ It returns oPool's copy of pcString, making one if there is none, and counts one more reference to it.
+ Interning equal strings returns the same pointer. If there is insufficient memory, it returns NULL.
+ A table created against oPool finds a key passed as this pointer by its address, without comparing characters; any other pointer to an equal string
+ is still found, but by strcmp, so only callers that keep and pass the interned pointers gain from the pool on lookups. */
+const char *SymTablePool_intern(SymTablePool_T oPool, const char *pcString);
+/* SymTablePool_internHashed behaves as SymTablePool_intern, but takes oKey, which must be SymTablePool_hashKey(oPool, pcString),
+ instead of hashing pcString. */
+const char *SymTablePool_internHashed(SymTablePool_T oPool, const char *pcString, SymTable_Key oKey);
+/* SymTablePool_hashKey is a function that takes two arguments, a SymTablePool_T type oPool and a constant char pointer pcString,
+ and returns the SymTable_Key of pcString in oPool and in every table created against it. */
+SymTable_Key SymTablePool_hashKey(SymTablePool_T oPool, const char *pcString);
+/* SymTablePool_keyOf is like SymTablePool_hashKey, but pcInterned must be a string returned by SymTablePool_intern(oPool, ...)
+ that is still referenced. It returns the SymTable_Key that oPool stored when it interned the string, without hashing it again. */
+SymTable_Key SymTablePool_keyOf(SymTablePool_T oPool, const char *pcInterned);
+/* SymTablePool_release is a function that takes two arguments, a SymTablePool_T type oPool and a constant char pointer pcInterned,
+ a string returned by SymTablePool_intern(oPool, ...). It counts one reference fewer to pcInterned, and frees it once none remain. */
+void SymTablePool_release(SymTablePool_T oPool, const char *pcInterned);
+#endif
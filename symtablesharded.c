@@ -0,0 +1,445 @@
+/* This code implements a symbol table that many threads may use at once, as a collection of independent hash tables called shards. The high bits of a key's hash choose its shard and the low bits its bucket within the shard. Each shard has its own lock, length, and arena, so threads working on different shards share nothing, and a shard expands without stopping the others. */
+
+#define _XOPEN_SOURCE 700
+
+#include <assert.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "symtable.h"
+#include "symtablearena.h"
+
+/* A new SymTable has SHARDS_PER_CPU shards per online processor,
+ rounded up to a power of two and kept between 2 to the power
+ MIN_SHARD_BITS and 2 to the power MAX_SHARD_BITS, so that threads
+ rarely pick the same shard at the same time. */
+enum {SHARDS_PER_CPU = 4, MIN_SHARD_BITS = 4, MAX_SHARD_BITS = 10};
+
+/* Number of buckets in a new shard. Always a power of two. */
+enum {INITIAL_BUCKETS = 64};
+
+/* Size of a cache line */
+enum {CACHE_LINE = 64};
+
+/* Each key-value binding pair is stored in a Binding structure.
+ Bindings  are linked with pointers to form a linked list. */
+struct SymTable_Node
+{
+  /* Values stored in void pointer. */
+  void *value;
+  /* Full hash of key, so expansion never rehashes the key. */
+  size_t hash;
+  /* Structure points to next binding in hash table. */
+  struct SymTable_Node *next;
+  /* Key bytes trail the node in the same allocation. */
+  char key[];
+};
+
+/* One shard, a hash table of its own */
+struct SymTable_Shard
+{
+  /* Held by every operation on the shard */
+  pthread_mutex_t lock;
+  /* struct Binding begins the shard's hash table */
+  struct SymTable_Node **buckets;
+  /* Number of buckets in the shard, a power of two */
+  size_t numOfBuckets;
+  /* Number of bindings in the shard. It changes only under the lock,
+     but SymTable_getLength reads it without. */
+  size_t length;
+  /* Arena that holds every SymTable_Node of the shard */
+  SymTableArena_T arena;
+  /* Keeps the fields of neighboring shards out of each other's cache
+     lines, so that threads on different shards never contend */
+  char padding[CACHE_LINE];
+};
+
+/* Begins sharded hash table */
+struct SymTable
+{
+  /* The shards */
+  struct SymTable_Shard *shards;
+  /* Number of shards, 2 to the power shardBits */
+  size_t numOfShards;
+  size_t shardBits;
+};
+
+/* Return a hash code for pcKey. Shards are chosen by its high bits and
+   buckets by its low bits, so the hash must mix well at both ends. */
+static size_t SymTable_hash(const char *pcKey)
+{
+  return SymTable_hashWord(pcKey, 0);
+}
+
+/* Return the shard of oSymTable that holds the bindings whose hash is
+   uHash. */
+static struct SymTable_Shard *SymTable_shard(SymTable_T oSymTable, size_t uHash)
+{
+  return &oSymTable->shards[uHash >> (sizeof(size_t) * CHAR_BIT
+                                      - oSymTable->shardBits)];
+}
+
+/* Return the number of bits that choose a shard in a new SymTable. */
+static size_t SymTable_shardBits(void)
+{
+  long cpus;
+  size_t bits = MIN_SHARD_BITS;
+
+  cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  while (bits < MAX_SHARD_BITS
+         && cpus > 0 && ((size_t)1 << bits) < (size_t)cpus * SHARDS_PER_CPU)
+  {
+    bits++;
+  }
+  return bits;
+}
+
+/* SymTable_find returns the node of shard whose key is pcKey and whose
+hash is uHash, or NULL if there is no such node. The caller must hold
+the shard's lock. */
+static struct SymTable_Node *SymTable_find(struct SymTable_Shard *shard,
+                                           const char *pcKey, size_t uHash)
+{
+  struct SymTable_Node *current;
+
+  for (current = shard->buckets[uHash & (shard->numOfBuckets - 1)];
+       current != NULL; current = current->next)
+  {
+    if (current->hash == uHash && strcmp(current->key, pcKey) == 0)
+    {
+      return current;
+    }
+  }
+  return NULL;
+}
+
+/* SymTable_expand doubles the number of buckets of shard, whose lock
+the caller holds, relinking every binding by its stored hash. If there
+is insufficient memory, shard keeps its buckets, which is harmless since
+chains merely grow longer. */
+static void SymTable_expand(struct SymTable_Shard *shard)
+{
+  struct SymTable_Node **newBuckets;
+  struct SymTable_Node *current;
+  struct SymTable_Node *next;
+  size_t newNumOfBuckets;
+  size_t i;
+
+  if (shard->numOfBuckets > SIZE_MAX / 2 / sizeof(struct SymTable_Node*))
+  {
+    return;
+  }
+
+  newNumOfBuckets = shard->numOfBuckets * 2;
+  newBuckets = calloc(newNumOfBuckets, sizeof(struct SymTable_Node*));
+  if (newBuckets == NULL)
+  {
+    return;
+  }
+
+  for (i = 0; i < shard->numOfBuckets; i++)
+  {
+    for (current = shard->buckets[i]; current != NULL; current = next)
+    {
+      next = current->next;
+      current->next = newBuckets[current->hash & (newNumOfBuckets - 1)];
+      newBuckets[current->hash & (newNumOfBuckets - 1)] = current;
+    }
+  }
+
+  free(shard->buckets);
+  shard->buckets = newBuckets;
+  shard->numOfBuckets = newNumOfBuckets;
+}
+
+/* Initialize shard as an empty shard. Return 0 if there is insufficient
+   memory, otherwise 1. */
+static int SymTable_initShard(struct SymTable_Shard *shard)
+{
+  shard->numOfBuckets = INITIAL_BUCKETS;
+  shard->length = 0;
+  shard->buckets = calloc(shard->numOfBuckets, sizeof(struct SymTable_Node*));
+  if (shard->buckets == NULL)
+  {
+    return 0;
+  }
+
+  shard->arena = SymTableArena_new();
+  if (shard->arena == NULL)
+  {
+    free(shard->buckets);
+    return 0;
+  }
+
+  if (pthread_mutex_init(&shard->lock, NULL) != 0)
+  {
+    SymTableArena_free(shard->arena);
+    free(shard->buckets);
+    return 0;
+  }
+  return 1;
+}
+
+/* Free all memory occupied by shard. */
+static void SymTable_freeShard(struct SymTable_Shard *shard)
+{
+  pthread_mutex_destroy(&shard->lock);
+  SymTableArena_free(shard->arena);
+  free(shard->buckets);
+}
+
+SymTable_T SymTable_new(void)
+{
+  SymTable_T oSymTable;
+  size_t i;
+
+  oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+  if (oSymTable == NULL)
+  {
+    return NULL;
+  }
+
+  oSymTable->shardBits = SymTable_shardBits();
+  oSymTable->numOfShards = (size_t)1 << oSymTable->shardBits;
+  oSymTable->shards = malloc(oSymTable->numOfShards
+                             * sizeof(struct SymTable_Shard));
+  if (oSymTable->shards == NULL)
+  {
+    free(oSymTable);
+    return NULL;
+  }
+
+  for (i = 0; i < oSymTable->numOfShards; i++)
+  {
+    if (! SymTable_initShard(&oSymTable->shards[i]))
+    {
+      while (i > 0)
+      {
+        i--;
+        SymTable_freeShard(&oSymTable->shards[i]);
+      }
+      free(oSymTable->shards);
+      free(oSymTable);
+      return NULL;
+    }
+  }
+
+  return oSymTable;
+}
+
+void SymTable_free(SymTable_T oSymTable)
+{
+  size_t i;
+
+  assert(oSymTable != NULL);
+
+  /* each shard's arena frees its bindings all at once */
+  for (i = 0; i < oSymTable->numOfShards; i++)
+  {
+    SymTable_freeShard(&oSymTable->shards[i]);
+  }
+
+  free(oSymTable->shards);
+  free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+  size_t length = 0;
+  size_t i;
+
+  assert(oSymTable != NULL);
+
+  /* bindings put or removed while the shards are summed may or may
+     not be counted */
+  for (i = 0; i < oSymTable->numOfShards; i++)
+  {
+    length += __atomic_load_n(&oSymTable->shards[i].length,
+                              __ATOMIC_RELAXED);
+  }
+
+  return length;
+}
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue)
+{
+  struct SymTable_Node *newNode;
+  struct SymTable_Shard *shard;
+  size_t hash;
+  size_t keyLength;
+  size_t bucket;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  hash = SymTable_hash(pcKey);
+  keyLength = strlen(pcKey);
+  shard = SymTable_shard(oSymTable, hash);
+  pthread_mutex_lock(&shard->lock);
+
+  if (SymTable_find(shard, pcKey, hash) != NULL)
+  {
+    pthread_mutex_unlock(&shard->lock);
+    return 0;
+  }
+
+  newNode = SymTableArena_alloc(shard->arena,
+                                sizeof(struct SymTable_Node) + keyLength + 1);
+  if (newNode == NULL)
+  {
+    pthread_mutex_unlock(&shard->lock);
+    return 0;
+  }
+  memcpy(newNode->key, pcKey, keyLength + 1);
+  newNode->value = (void*) pvValue;
+  newNode->hash = hash;
+
+  bucket = hash & (shard->numOfBuckets - 1);
+  newNode->next = shard->buckets[bucket];
+  shard->buckets[bucket] = newNode;
+  __atomic_store_n(&shard->length, shard->length + 1, __ATOMIC_RELAXED);
+
+  /* expansion check: the shard holds more bindings than buckets */
+  if (shard->length > shard->numOfBuckets)
+  {
+    SymTable_expand(shard);
+  }
+
+  pthread_mutex_unlock(&shard->lock);
+  return 1;
+}
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue)
+{
+  struct SymTable_Node *found;
+  struct SymTable_Shard *shard;
+  void *oldVal = NULL;
+  size_t hash;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  hash = SymTable_hash(pcKey);
+  shard = SymTable_shard(oSymTable, hash);
+  pthread_mutex_lock(&shard->lock);
+
+  found = SymTable_find(shard, pcKey, hash);
+  if (found != NULL)
+  {
+    oldVal = found->value;
+    found->value = (void*) pvValue;
+  }
+
+  pthread_mutex_unlock(&shard->lock);
+  return oldVal;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+  struct SymTable_Shard *shard;
+  size_t hash;
+  int found;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  hash = SymTable_hash(pcKey);
+  shard = SymTable_shard(oSymTable, hash);
+  pthread_mutex_lock(&shard->lock);
+
+  found = SymTable_find(shard, pcKey, hash) != NULL;
+
+  pthread_mutex_unlock(&shard->lock);
+  return found;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+  struct SymTable_Node *found;
+  struct SymTable_Shard *shard;
+  void *value = NULL;
+  size_t hash;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  hash = SymTable_hash(pcKey);
+  shard = SymTable_shard(oSymTable, hash);
+  pthread_mutex_lock(&shard->lock);
+
+  found = SymTable_find(shard, pcKey, hash);
+  if (found != NULL)
+  {
+    value = found->value;
+  }
+
+  pthread_mutex_unlock(&shard->lock);
+  return value;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+  struct SymTable_Node *current;
+  struct SymTable_Node **link;
+  struct SymTable_Shard *shard;
+  void *holdVal = NULL;
+  size_t hash;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  hash = SymTable_hash(pcKey);
+  shard = SymTable_shard(oSymTable, hash);
+  pthread_mutex_lock(&shard->lock);
+
+  link = &shard->buckets[hash & (shard->numOfBuckets - 1)];
+  for (current = *link; current != NULL; current = *link)
+  {
+    if (current->hash == hash && strcmp(current->key, pcKey) == 0)
+    {
+      *link = current->next;
+      holdVal = current->value;
+      SymTableArena_release(shard->arena, current,
+                            sizeof(struct SymTable_Node)
+                            + strlen(current->key) + 1);
+      __atomic_store_n(&shard->length, shard->length - 1, __ATOMIC_RELAXED);
+      break;
+    }
+    link = &current->next;
+  }
+
+  pthread_mutex_unlock(&shard->lock);
+  return holdVal;
+}
+
+void SymTable_map(SymTable_T oSymTable, void(*pfApply)(const char *pcKey, void *pvValue, void *pvExtra), const void *pvExtra)
+{
+  struct SymTable_Shard *shard;
+  struct SymTable_Node *current;
+  size_t i;
+  size_t j;
+
+  assert(oSymTable != NULL);
+  assert(pfApply != NULL);
+
+  /* each shard is mapped under its own lock, so other shards stay
+     usable, and bindings put or removed in them meanwhile may or may
+     not be visited. pfApply must not modify oSymTable. */
+  for (i = 0; i < oSymTable->numOfShards; i++)
+  {
+    shard = &oSymTable->shards[i];
+    pthread_mutex_lock(&shard->lock);
+    for (j = 0; j < shard->numOfBuckets; j++)
+    {
+      for (current = shard->buckets[j]; current != NULL;
+           current = current->next)
+      {
+        (*pfApply)(current->key, current->value, (void*)pvExtra);
+      }
+    }
+    pthread_mutex_unlock(&shard->lock);
+  }
+}
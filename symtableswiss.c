@@ -0,0 +1,461 @@
+/* This code implements a symbol table using an open addressing hash table in the style of SwissTable. Slots are grouped in sixteens, and each group keeps a control byte per slot holding a 7-bit fingerprint of that slot's hash. A lookup scans a whole group's control bytes at once (with SSE2 when available) and only calls strcmp on slots whose fingerprint matches. */
+
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+#include "symtable.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* Number of slots that share one scan of control bytes */
+enum {GROUP_WIDTH = 16};
+
+/* Number of groups in a new SymTable. Always a power of two. */
+enum {INITIAL_GROUPS = 1};
+
+/* The table grows once more than MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR
+ of its slots would be full or deleted. */
+enum {MAX_LOAD_NUMERATOR = 7, MAX_LOAD_DENOMINATOR = 8};
+
+/* Control byte values. A full slot's control byte is the low 7 bits of
+ its hash, so it never has the high bit set. */
+enum {CTRL_EMPTY = 0x80, CTRL_DELETED = 0xFE};
+
+/* Each key-value binding pair is stored in a SymTable_Slot structure. */
+struct SymTable_Slot
+{
+  /* Keys stored in constant char pointer. */
+  const char *key;
+  /* Values stored in void pointer. */
+  void *value;
+};
+
+/* Begins SwissTable-style hash table */
+struct SymTable
+{
+  /* Number of bindings is the length */
+  size_t length;
+  /* Number of slots whose control byte is CTRL_DELETED */
+  size_t deleted;
+  /* One control byte per slot */
+  unsigned char *ctrl;
+  /* Array of slots holding the bindings */
+  struct SymTable_Slot *slots;
+  /* Number of groups, a power of two; there are
+     numOfGroups * GROUP_WIDTH slots */
+  size_t numOfGroups;
+};
+
+/* Return a hash code for pcKey. The 65599 polynomial is followed by a
+   finalizer because groups are indexed by masking the hash and
+   fingerprints are its low 7 bits. */
+static size_t SymTable_hash(const char *pcKey)
+{
+   const size_t HASH_MULTIPLIER = 65599;
+   size_t u;
+   size_t uHash = 0;
+
+   assert(pcKey != NULL);
+
+   for (u = 0; pcKey[u] != '\0'; u++)
+      uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+
+   uHash ^= uHash >> 15;
+   uHash *= (size_t)0x2c1b3c6dU;
+   uHash ^= uHash >> 12;
+   uHash *= (size_t)0x297a2d39U;
+   uHash ^= uHash >> 15;
+   return uHash;
+}
+
+/* Return the control byte fingerprint of uHash. */
+static unsigned char SymTable_fingerprint(size_t uHash)
+{
+  return (unsigned char)(uHash & 0x7F);
+}
+
+/* Return the group at which probing for uHash begins in oSymTable. */
+static size_t SymTable_homeGroup(SymTable_T oSymTable, size_t uHash)
+{
+  return (uHash >> 7) & (oSymTable->numOfGroups - 1);
+}
+
+/* Return a bit mask with bit i set for each i in [0, GROUP_WIDTH) such
+   that pucGroup[i] == ucByte. */
+static unsigned SymTable_match(const unsigned char *pucGroup, unsigned char ucByte)
+{
+#ifdef __SSE2__
+  __m128i group = _mm_loadu_si128((const __m128i*)pucGroup);
+  __m128i byte = _mm_set1_epi8((char)ucByte);
+  return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(group, byte));
+#else
+  unsigned mask = 0;
+  int i;
+
+  for (i = 0; i < GROUP_WIDTH; i++)
+  {
+    if (pucGroup[i] == ucByte)
+    {
+      mask |= 1U << i;
+    }
+  }
+  return mask;
+#endif
+}
+
+/* Return a bit mask with bit i set for each empty or deleted slot i in
+   the group of control bytes pucGroup. Both have the high bit set. */
+static unsigned SymTable_matchFree(const unsigned char *pucGroup)
+{
+#ifdef __SSE2__
+  __m128i group = _mm_loadu_si128((const __m128i*)pucGroup);
+  return (unsigned)_mm_movemask_epi8(group);
+#else
+  unsigned mask = 0;
+  int i;
+
+  for (i = 0; i < GROUP_WIDTH; i++)
+  {
+    if ((pucGroup[i] & 0x80) != 0)
+    {
+      mask |= 1U << i;
+    }
+  }
+  return mask;
+#endif
+}
+
+/* Return the index of the lowest set bit of the nonzero uMask. */
+static int SymTable_lowestBit(unsigned uMask)
+{
+#ifdef __GNUC__
+  assert(uMask != 0);
+
+  return __builtin_ctz(uMask);
+#else
+  int i = 0;
+
+  assert(uMask != 0);
+
+  while ((uMask & 1U) == 0)
+  {
+    uMask >>= 1;
+    i++;
+  }
+  return i;
+#endif
+}
+
+/* SymTable_find returns the index of the slot of oSymTable whose key is
+pcKey, given that pcKey hashes to uHash, or the number of slots of
+oSymTable if there is no such slot. Groups are probed triangularly,
+which visits every group once, and probing ends at the first group
+with an empty slot. */
+static size_t SymTable_find(SymTable_T oSymTable, const char *pcKey, size_t uHash)
+{
+  unsigned char fingerprint = SymTable_fingerprint(uHash);
+  size_t groupMask = oSymTable->numOfGroups - 1;
+  size_t group = SymTable_homeGroup(oSymTable, uHash);
+  size_t step;
+  size_t index;
+  const unsigned char *ctrl;
+  unsigned matches;
+
+  for (step = 1; step <= oSymTable->numOfGroups; step++)
+  {
+    ctrl = oSymTable->ctrl + group * GROUP_WIDTH;
+    for (matches = SymTable_match(ctrl, fingerprint);
+         matches != 0;
+         matches &= matches - 1)
+    {
+      index = group * GROUP_WIDTH + (size_t)SymTable_lowestBit(matches);
+      if (strcmp(oSymTable->slots[index].key, pcKey) == 0)
+      {
+        return index;
+      }
+    }
+    if (SymTable_match(ctrl, CTRL_EMPTY) != 0)
+    {
+      break;
+    }
+    group = (group + step) & groupMask;
+  }
+  return oSymTable->numOfGroups * GROUP_WIDTH;
+}
+
+/* SymTable_findFree returns the index of the first empty or deleted
+slot along the probe sequence of uHash in oSymTable, which must have
+at least one such slot. */
+static size_t SymTable_findFree(SymTable_T oSymTable, size_t uHash)
+{
+  size_t groupMask = oSymTable->numOfGroups - 1;
+  size_t group = SymTable_homeGroup(oSymTable, uHash);
+  size_t step;
+  unsigned frees;
+
+  for (step = 1; ; step++)
+  {
+    frees = SymTable_matchFree(oSymTable->ctrl + group * GROUP_WIDTH);
+    if (frees != 0)
+    {
+      return group * GROUP_WIDTH + (size_t)SymTable_lowestBit(frees);
+    }
+    group = (group + step) & groupMask;
+  }
+}
+
+/* SymTable_resize rebuilds oSymTable with uNumOfGroups groups,
+reinserting every binding and dropping all deleted slots. If there is
+insufficient memory, it returns 0 and leaves oSymTable unchanged.
+Otherwise it returns 1. */
+static int SymTable_resize(SymTable_T oSymTable, size_t uNumOfGroups)
+{
+  unsigned char *oldCtrl;
+  struct SymTable_Slot *oldSlots;
+  size_t oldNumOfSlots;
+  size_t hash;
+  size_t index;
+  size_t i;
+
+  assert(oSymTable != NULL);
+
+  oldCtrl = oSymTable->ctrl;
+  oldSlots = oSymTable->slots;
+  oldNumOfSlots = oSymTable->numOfGroups * GROUP_WIDTH;
+
+  oSymTable->ctrl = malloc(uNumOfGroups * GROUP_WIDTH);
+  oSymTable->slots = malloc(uNumOfGroups * GROUP_WIDTH * sizeof(struct SymTable_Slot));
+  if (oSymTable->ctrl == NULL || oSymTable->slots == NULL)
+  {
+    free(oSymTable->ctrl);
+    free(oSymTable->slots);
+    oSymTable->ctrl = oldCtrl;
+    oSymTable->slots = oldSlots;
+    return 0;
+  }
+  memset(oSymTable->ctrl, CTRL_EMPTY, uNumOfGroups * GROUP_WIDTH);
+  oSymTable->numOfGroups = uNumOfGroups;
+  oSymTable->deleted = 0;
+
+  for (i = 0; i < oldNumOfSlots; i++)
+  {
+    if ((oldCtrl[i] & 0x80) == 0)
+    {
+      hash = SymTable_hash(oldSlots[i].key);
+      index = SymTable_findFree(oSymTable, hash);
+      oSymTable->ctrl[index] = SymTable_fingerprint(hash);
+      oSymTable->slots[index] = oldSlots[i];
+    }
+  }
+
+  free(oldCtrl);
+  free(oldSlots);
+  return 1;
+}
+
+SymTable_T SymTable_new(void)
+{
+  SymTable_T oSymTable;
+
+  oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+  if (oSymTable == NULL)
+  {
+    return NULL;
+  }
+
+  oSymTable->length = 0;
+  oSymTable->deleted = 0;
+  oSymTable->numOfGroups = INITIAL_GROUPS;
+  oSymTable->ctrl = malloc(INITIAL_GROUPS * GROUP_WIDTH);
+  oSymTable->slots = malloc(INITIAL_GROUPS * GROUP_WIDTH * sizeof(struct SymTable_Slot));
+  if (oSymTable->ctrl == NULL || oSymTable->slots == NULL)
+  {
+    free(oSymTable->ctrl);
+    free(oSymTable->slots);
+    free(oSymTable);
+    return NULL;
+  }
+  memset(oSymTable->ctrl, CTRL_EMPTY, INITIAL_GROUPS * GROUP_WIDTH);
+
+  return oSymTable;
+}
+
+void SymTable_free(SymTable_T oSymTable)
+{
+  size_t i;
+
+  assert(oSymTable != NULL);
+
+  for (i = 0; i < oSymTable->numOfGroups * GROUP_WIDTH; i++)
+  {
+    if ((oSymTable->ctrl[i] & 0x80) == 0)
+    {
+      free((void*) oSymTable->slots[i].key);
+    }
+  }
+
+  free(oSymTable->ctrl);
+  free(oSymTable->slots);
+  free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+  assert(oSymTable != NULL);
+
+  return oSymTable->length;
+}
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue)
+{
+  char *defCopyofKey;
+  size_t numOfSlots;
+  size_t newNumOfGroups;
+  size_t hash;
+  size_t index;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  hash = SymTable_hash(pcKey);
+  numOfSlots = oSymTable->numOfGroups * GROUP_WIDTH;
+  if (SymTable_find(oSymTable, pcKey, hash) != numOfSlots)
+  {
+    return 0;
+  }
+
+  /* expansion check: deleted slots count against the load since they
+     lengthen probe sequences. Rebuilding at the same size is enough
+     when deleted slots are most of the load. */
+  if ((oSymTable->length + oSymTable->deleted + 1) * MAX_LOAD_DENOMINATOR
+      > numOfSlots * MAX_LOAD_NUMERATOR)
+  {
+    newNumOfGroups = oSymTable->numOfGroups;
+    if (oSymTable->length >= oSymTable->deleted)
+    {
+      newNumOfGroups *= 2;
+    }
+    if (! SymTable_resize(oSymTable, newNumOfGroups)
+        && oSymTable->length + oSymTable->deleted + 1 >= numOfSlots)
+    {
+      return 0;
+    }
+  }
+
+  /* create defensive copy */
+  defCopyofKey = (char*)malloc(strlen(pcKey) + 1);
+  if (defCopyofKey == NULL)
+  {
+    return 0;
+  }
+  strcpy(defCopyofKey, pcKey);
+
+  index = SymTable_findFree(oSymTable, hash);
+  if (oSymTable->ctrl[index] == CTRL_DELETED)
+  {
+    oSymTable->deleted--;
+  }
+  oSymTable->ctrl[index] = SymTable_fingerprint(hash);
+  oSymTable->slots[index].key = defCopyofKey;
+  oSymTable->slots[index].value = (void*) pvValue;
+  oSymTable->length++;
+  return 1;
+}
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue)
+{
+  void *oldVal;
+  size_t index;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  index = SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey));
+  if (index == oSymTable->numOfGroups * GROUP_WIDTH)
+  {
+    return NULL;
+  }
+
+  oldVal = oSymTable->slots[index].value;
+  oSymTable->slots[index].value = (void*) pvValue;
+  return oldVal;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  return SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey))
+    != oSymTable->numOfGroups * GROUP_WIDTH;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+  size_t index;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  index = SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey));
+  if (index == oSymTable->numOfGroups * GROUP_WIDTH)
+  {
+    return NULL;
+  }
+  return oSymTable->slots[index].value;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+  void *holdVal;
+  size_t index;
+  const unsigned char *group;
+
+  assert(oSymTable != NULL);
+  assert(pcKey != NULL);
+
+  index = SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey));
+  if (index == oSymTable->numOfGroups * GROUP_WIDTH)
+  {
+    return NULL;
+  }
+
+  holdVal = oSymTable->slots[index].value;
+  free((void*) oSymTable->slots[index].key);
+
+  /* A group that still has an empty slot has never ended a probe
+     sequence that continued past it, so the slot can become empty
+     again. Otherwise it must stay marked as deleted. */
+  group = oSymTable->ctrl + (index / GROUP_WIDTH) * GROUP_WIDTH;
+  if (SymTable_match(group, CTRL_EMPTY) != 0)
+  {
+    oSymTable->ctrl[index] = CTRL_EMPTY;
+  }
+  else
+  {
+    oSymTable->ctrl[index] = CTRL_DELETED;
+    oSymTable->deleted++;
+  }
+
+  oSymTable->length--;
+  return holdVal;
+}
+
+void SymTable_map(SymTable_T oSymTable, void(*pfApply)(const char *pcKey, void *pvValue, void *pvExtra), const void *pvExtra)
+{
+  size_t i;
+
+  assert(oSymTable != NULL);
+  assert(pfApply != NULL);
+
+  for (i = 0; i < oSymTable->numOfGroups * GROUP_WIDTH; i++)
+  {
+    if ((oSymTable->ctrl[i] & 0x80) == 0)
+    {
+      (*pfApply)(oSymTable->slots[i].key, oSymTable->slots[i].value,
+                 (void*)pvExtra);
+    }
+  }
+}
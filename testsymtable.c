@@ -14,12 +14,57 @@
 #include <sys/resource.h>
 #endif
 
+#ifdef HAS_THREADS
+#include <pthread.h>
+#endif
+#ifdef HAS_KEY_POOL
+#include "symtablepool.h"
+#endif
+
 /*--------------------------------------------------------------------*/
 
 #define ASSURE(i) assure(i, __LINE__)
 
 /*--------------------------------------------------------------------*/
 
+#ifdef COUNT_ALLOCATIONS
+/* The number of heap allocations made so far. The Makefile links
+   with --wrap=malloc, --wrap=calloc, and --wrap=realloc, so every
+   such call in the program goes through the wrappers below. */
+
+static unsigned long ulAllocationCount = 0;
+
+void *__real_malloc(size_t uSize);
+void *__real_calloc(size_t uCount, size_t uSize);
+void *__real_realloc(void *pvBlock, size_t uSize);
+
+/* Count, then perform, a call of malloc(uSize). */
+
+void *__wrap_malloc(size_t uSize)
+{
+   ulAllocationCount++;
+   return __real_malloc(uSize);
+}
+
+/* Count, then perform, a call of calloc(uCount, uSize). */
+
+void *__wrap_calloc(size_t uCount, size_t uSize)
+{
+   ulAllocationCount++;
+   return __real_calloc(uCount, uSize);
+}
+
+/* Count, then perform, a call of realloc(pvBlock, uSize). */
+
+void *__wrap_realloc(void *pvBlock, size_t uSize)
+{
+   ulAllocationCount++;
+   return __real_realloc(pvBlock, uSize);
+}
+#endif
+
+/*--------------------------------------------------------------------*/
+
 /* If !iSuccessful, print a message to stdout indicating that the
    test at line iLineNum failed. */
 
@@ -696,6 +741,96 @@ static void testTableOfTables(void)
 
 /*--------------------------------------------------------------------*/
 
+/* Increment *pvCount, an int. */
+
+static void countBinding(const char *pcKey, void *pvValue,
+   void *pvCount)
+{
+   assert(pcKey != NULL);
+   assert(pvCount != NULL);
+   (void)pvValue;
+
+   (*(int*)pvCount)++;
+}
+
+/* Test many SymTable objects that each contain a few bindings, as the
+   scopes of a program do, some of them with a few too many to stay
+   small. */
+
+static void testSmallTables(void)
+{
+   enum {TABLE_COUNT = 200, MAX_BINDING_COUNT = 20, MAX_KEY_LENGTH = 12};
+
+   SymTable_T aoSymTables[TABLE_COUNT];
+   char acKey[MAX_KEY_LENGTH];
+   int i;
+   int j;
+   int iCount;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing many small SymTable objects.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* Table i has i % MAX_BINDING_COUNT bindings. */
+   for (i = 0; i < TABLE_COUNT; i++)
+   {
+      aoSymTables[i] = SymTable_new();
+      ASSURE(aoSymTables[i] != NULL);
+      for (j = 0; j < i % MAX_BINDING_COUNT; j++)
+      {
+         sprintf(acKey, "x%d", j);
+         iSuccessful = SymTable_put(aoSymTables[i], acKey, aoSymTables[i]);
+         ASSURE(iSuccessful);
+         iSuccessful = SymTable_put(aoSymTables[i], acKey, NULL);
+         ASSURE(! iSuccessful);
+      }
+   }
+
+   /* Remove every even binding, and make sure that the others remain
+      in the table they were put in. */
+   for (i = 0; i < TABLE_COUNT; i++)
+   {
+      for (j = 0; j < i % MAX_BINDING_COUNT; j += 2)
+      {
+         sprintf(acKey, "x%d", j);
+         ASSURE(SymTable_remove(aoSymTables[i], acKey) == aoSymTables[i]);
+      }
+      for (j = 0; j < MAX_BINDING_COUNT; j++)
+      {
+         sprintf(acKey, "x%d", j);
+         ASSURE(SymTable_contains(aoSymTables[i], acKey)
+            == (j % 2 == 1 && j < i % MAX_BINDING_COUNT));
+      }
+      ASSURE(SymTable_getLength(aoSymTables[i])
+         == (size_t)(i % MAX_BINDING_COUNT / 2));
+      iCount = 0;
+      SymTable_map(aoSymTables[i], countBinding, &iCount);
+      ASSURE(iCount == i % MAX_BINDING_COUNT / 2);
+   }
+
+   /* Refill each table past its original size. */
+   for (i = 0; i < TABLE_COUNT; i++)
+   {
+      for (j = 0; j < MAX_BINDING_COUNT; j += 2)
+      {
+         sprintf(acKey, "x%d", j);
+         iSuccessful = SymTable_put(aoSymTables[i], acKey, aoSymTables[i]);
+         ASSURE(iSuccessful);
+      }
+      for (j = 0; j < MAX_BINDING_COUNT; j++)
+      {
+         sprintf(acKey, "x%d", j);
+         ASSURE(SymTable_contains(aoSymTables[i], acKey)
+            == (j % 2 == 0 || j < i % MAX_BINDING_COUNT));
+      }
+      SymTable_free(aoSymTables[i]);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
 /* Test the ability of a SymTable object to handle collisions.  This
    test assumes that a SymTable object is implemented as a hash table,
    that there are 509 buckets in the hash table, and that the
@@ -776,182 +911,1967 @@ static void testCollisions(void)
 
 /*--------------------------------------------------------------------*/
 
-/* Test the ability of a SymTable object to be large, that is, to
-   contain iBindingCount bindings. Write the time consumed to stdout. */
+#ifdef HAS_NEW_WITH_HASH
+/* Test SymTable objects created by SymTable_newWithHash() with
+   each of the provided hash functions, using the keys that collide
+   under the hash function from the assignment specification. */
 
-static void testLargeTable(int iBindingCount)
+static void testHashFunctions(void)
 {
-   enum {MAX_KEY_LENGTH = 10};
+   enum {KEY_COUNT = 5, LONG_KEY_SIZE = 100};
 
+   SymTable_HashFunction apfHash[] =
+      {SymTable_hashPolynomial, SymTable_hashWord};
+   const char *apcKeys[KEY_COUNT] = {"250", "469", "947", "1303", "2016"};
+   char acLongKey[LONG_KEY_SIZE];
+   char acShortstop[] = "Shortstop";
    SymTable_T oSymTable;
-   SymTable_T oSymTableSmall;
-   char acKey[MAX_KEY_LENGTH];
-   char *pcValue;
+   size_t uSeed;
+   size_t u;
    int i;
-   int iSmall;
-   int iLarge;
    int iSuccessful;
-   clock_t iInitialClock;
-   clock_t iFinalClock;
-   size_t uLength = 0;
-   size_t uLength2;
 
    printf("------------------------------------------------------\n");
-   printf("Testing a potentially large SymTable object.\n");
-   printf("No output except CPU time consumed should appear here:\n");
+   printf("Testing SymTable objects with seeded hash functions.\n");
+   printf("No output should appear here:\n");
    fflush(stdout);
 
-   /* Note the current time. */
-   iInitialClock = clock();
+   for (i = 0; i < LONG_KEY_SIZE - 1; i++)
+      acLongKey[i] = (char)('a' + i % 26);
+   acLongKey[LONG_KEY_SIZE - 1] = '\0';
 
-   /* Create oSymTableSmall, and put a couple of bindings into it. */
-   oSymTableSmall = SymTable_new();
-   ASSURE(oSymTableSmall != NULL);
-   iSuccessful = SymTable_put(oSymTableSmall, "xxx", "xxx");
-   ASSURE(iSuccessful);
-   iSuccessful = SymTable_put(oSymTableSmall, "yyy", "yyy");
-   ASSURE(iSuccessful);
+   /* A hash function must depend only on its key and seed. */
+   ASSURE(SymTable_hashWord(acLongKey, 1) == SymTable_hashWord(acLongKey, 1));
+   ASSURE(SymTable_hashWord(acLongKey, 1) != SymTable_hashWord(acLongKey, 2));
+   ASSURE(SymTable_hashWord("250", 0) != SymTable_hashWord("469", 0));
+   ASSURE(SymTable_hashPolynomial("250", 0) % 509
+      == SymTable_hashPolynomial("469", 0) % 509);
 
-   /* Create oSymTable, the primary SymTable object. */
-   oSymTable = SymTable_new();
-   ASSURE(oSymTable != NULL);
+   uSeed = SymTable_randomSeed();
+   ASSURE(SymTable_randomSeed() != uSeed);
 
-   /* Put iBindingCount new bindings into oSymTable.  Each binding's
-      key and value contain the same characters. */
-   for (i = 0; i < iBindingCount; i++)
+   for (u = 0; u < sizeof(apfHash) / sizeof(apfHash[0]); u++)
    {
-      sprintf(acKey, "%d", i);
-      pcValue = (char*)malloc(sizeof(char) * (strlen(acKey) + 1));
-      ASSURE(pcValue != NULL);
-      strcpy(pcValue, acKey);
-      iSuccessful = SymTable_put(oSymTable, acKey, pcValue);
+      oSymTable = SymTable_newWithHash(apfHash[u], SymTable_randomSeed());
+      ASSURE(oSymTable != NULL);
+
+      for (i = 0; i < KEY_COUNT; i++)
+      {
+         iSuccessful = SymTable_put(oSymTable, apcKeys[i], apcKeys[i]);
+         ASSURE(iSuccessful);
+      }
+      iSuccessful = SymTable_put(oSymTable, acLongKey, acShortstop);
       ASSURE(iSuccessful);
-      uLength = SymTable_getLength(oSymTable);
-      ASSURE(uLength == (size_t)(i+1));
-   }
+      iSuccessful = SymTable_put(oSymTable, "250", acShortstop);
+      ASSURE(! iSuccessful);
+      ASSURE(SymTable_getLength(oSymTable) == KEY_COUNT + 1);
 
-   /* Get each binding's value, and make sure that it contains
-      the same characters as its key. */
-   iSmall = 0;
-   iLarge = iBindingCount - 1;
-   while (iSmall < iLarge)
-   {
-      /* Get the smallest of the remaining bindings. */
-      sprintf(acKey, "%d", iSmall);
-      pcValue = (char*)SymTable_get(oSymTable, acKey);
-      ASSURE(pcValue != NULL);
-      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
-      iSmall++;
-      /* Get the largest of the remaining bindings. */
-      sprintf(acKey, "%d", iLarge);
-      pcValue = (char*)SymTable_get(oSymTable, acKey);
-      ASSURE(pcValue != NULL);
-      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
-      iLarge--;
-   }
-   /* Get the middle binding -- if there is one. */
-   if (iSmall == iLarge)
-   {
-      sprintf(acKey, "%d", iSmall);
-      pcValue = (char*)SymTable_get(oSymTable, acKey);
-      ASSURE(pcValue != NULL);
-      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
-   }
+      for (i = 0; i < KEY_COUNT; i++)
+         ASSURE(SymTable_get(oSymTable, apcKeys[i]) == apcKeys[i]);
+      ASSURE(SymTable_get(oSymTable, acLongKey) == acShortstop);
 
-   /* Remove each binding. Also free each binding's value. */
-   iSmall = 0;
-   iLarge = iBindingCount - 1;
-   while (iSmall < iLarge)
-   {
-      /* Remove the smallest of the remaining bindings. */
-      sprintf(acKey, "%d", iSmall);
-      pcValue = (char*)SymTable_remove(oSymTable, acKey);
-      ASSURE(pcValue != NULL);
-      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
-      free(pcValue);
-      uLength--;
-      uLength2 = SymTable_getLength(oSymTable);
-      ASSURE(uLength2 == uLength);
-      iSmall++;
-      /* Remove the largest of the remaining bindings. */
-      sprintf(acKey, "%d", iLarge);
-      pcValue = (char*)SymTable_remove(oSymTable, acKey);
-      ASSURE(pcValue != NULL);
-      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
-      free(pcValue);
-      uLength--;
-      uLength2 = SymTable_getLength(oSymTable);
-      ASSURE(uLength2 == uLength);
-      iLarge--;
-   }
-   /* Remove the middle binding -- if there is one. */
-   if (iSmall == iLarge)
-   {
-      sprintf(acKey, "%d", iSmall);
-      pcValue = (char*)SymTable_remove(oSymTable, acKey);
-      ASSURE(pcValue != NULL);
-      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
-      free(pcValue);
-      uLength--;
-      uLength2 = SymTable_getLength(oSymTable);
-      ASSURE(uLength2 == uLength);  
+      ASSURE(SymTable_remove(oSymTable, "947") == apcKeys[2]);
+      ASSURE(! SymTable_contains(oSymTable, "947"));
+      ASSURE(SymTable_contains(oSymTable, "1303"));
+
+      SymTable_free(oSymTable);
    }
+}
+#endif
 
-   /* Make sure oSymTableSmall hasn't been corrupted by expansion
-      of oSymTable. */
-   pcValue = (char*)SymTable_get(oSymTableSmall, "xxx");
-   ASSURE((pcValue != NULL) && (strcmp(pcValue, "xxx") == 0));
-   pcValue = (char*)SymTable_get(oSymTableSmall, "yyy");
-   ASSURE((pcValue != NULL) && (strcmp(pcValue, "yyy") == 0));
+/*--------------------------------------------------------------------*/
 
-   /* Free both SymTable objects. */
-   SymTable_free(oSymTable);
-   SymTable_free(oSymTableSmall);
+#ifdef HAS_HASHED_KEYS
+/* Test the SymTable_hashKey(), SymTable_putHashed(),
+   SymTable_getHashed(), and SymTable_removeHashed() functions. */
 
-   /* Note the current time, and print the time consumed to stdout. */
-   iFinalClock = clock();
-   printf("CPU time (%d bindings):  %f seconds\n", iBindingCount,
-      ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC);
+static void testHashedKeys(void)
+{
+   SymTable_T oSymTable;
+   SymTable_Key oJeter;
+   SymTable_Key oMantle;
+   SymTable_Key oRuth;
+   char acJeter[] = "Jeter";
+   char acMantle[] = "Mantle";
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "Center Field";
+   char *pcValue;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable functions that take hashed keys.\n");
+   printf("No output should appear here:\n");
    fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   oJeter = SymTable_hashKey(oSymTable, acJeter);
+   oMantle = SymTable_hashKey(oSymTable, acMantle);
+   oRuth = SymTable_hashKey(oSymTable, "Ruth");
+
+   iSuccessful = SymTable_putHashed(oSymTable, acJeter, oJeter,
+      acShortstop);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putHashed(oSymTable, "Jeter", oJeter,
+      acCenterField);
+   ASSURE(! iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, acMantle, acCenterField);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+
+   /* Hashed and unhashed functions must agree. */
+   pcValue = (char*)SymTable_getHashed(oSymTable, acMantle, oMantle);
+   ASSURE(pcValue == acCenterField);
+   pcValue = (char*)SymTable_get(oSymTable, acJeter);
+   ASSURE(pcValue == acShortstop);
+   pcValue = (char*)SymTable_getHashed(oSymTable, "Jeter", oJeter);
+   ASSURE(pcValue == acShortstop);
+   pcValue = (char*)SymTable_getHashed(oSymTable, "Ruth", oRuth);
+   ASSURE(pcValue == NULL);
+
+   /* Changing the caller's copy of the key must not matter. */
+   acJeter[0] = 'X';
+   pcValue = (char*)SymTable_getHashed(oSymTable, "Jeter", oJeter);
+   ASSURE(pcValue == acShortstop);
+
+   pcValue = (char*)SymTable_removeHashed(oSymTable, "Ruth", oRuth);
+   ASSURE(pcValue == NULL);
+   pcValue = (char*)SymTable_removeHashed(oSymTable, "Jeter", oJeter);
+   ASSURE(pcValue == acShortstop);
+   pcValue = (char*)SymTable_getHashed(oSymTable, "Jeter", oJeter);
+   ASSURE(pcValue == NULL);
+   pcValue = (char*)SymTable_remove(oSymTable, acMantle);
+   ASSURE(pcValue == acCenterField);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+
+   SymTable_free(oSymTable);
 }
+#endif
 
 /*--------------------------------------------------------------------*/
 
-/* Test the SymTable ADT.  Write the output of the tests to stdout.
-   As always, argc is the command-line argument count, argv contains
-   the command-line arguments, and argv[0] is the name of the
-   executable binary file. argv[1] is the number of bindings to put
-   into a potentially large SymTable object.  Exit with EXIT_FAILURE
-   if argv[1] is missing or not numeric.  Otherwise return 0. */
+#ifdef HAS_KEY_POOL
+/* Test SymTable objects created by SymTable_newWithPool() that share
+   one SymTablePool_T. */
 
-int main(int argc, char *argv[])
+static void testKeyPool(void)
 {
-   int iBindingCount;
+   enum {KEY_COUNT = 100, MAX_KEY_LENGTH = 12};
 
-   if (argc != 2)
-   {
-      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
-      exit(EXIT_FAILURE);
-   }
+   SymTablePool_T oPool;
+   SymTable_T oSymTable1;
+   SymTable_T oSymTable2;
+   SymTable_Iterator oIterator;
+   const char *apcInterned[KEY_COUNT];
+   char acKey[MAX_KEY_LENGTH];
+   int i;
+   int iSuccessful;
 
-   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_newWithPool() and SymTablePool_T.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oPool = SymTablePool_new();
+   ASSURE(oPool != NULL);
+   oSymTable1 = SymTable_newWithPool(oPool);
+   ASSURE(oSymTable1 != NULL);
+   oSymTable2 = SymTable_newWithPool(oPool);
+   ASSURE(oSymTable2 != NULL);
+
+   /* Both tables bind the same keys, which the pool stores once. */
+   for (i = 0; i < KEY_COUNT; i++)
    {
-      fprintf(stderr, "bindingcount must be numeric\n");
-      exit(EXIT_FAILURE);
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable1, acKey, oSymTable1);
+      ASSURE(iSuccessful);
+      iSuccessful = SymTable_put(oSymTable2, acKey, oSymTable2);
+      ASSURE(iSuccessful);
+      iSuccessful = SymTable_put(oSymTable2, acKey, NULL);
+      ASSURE(! iSuccessful);
    }
-   if (iBindingCount < 0)
+   ASSURE(SymTablePool_getLength(oPool) == KEY_COUNT);
+
+   /* Interning a bound key returns the tables' own copy, which looks
+      up the same bindings as any equal string. The test keeps one
+      reference to each key. */
+   for (i = 0; i < KEY_COUNT; i++)
    {
-      fprintf(stderr, "bindingcount cannot be negative\n");
-      exit(EXIT_FAILURE);
+      sprintf(acKey, "%d", i);
+      apcInterned[i] = SymTablePool_intern(oPool, acKey);
+      ASSURE(apcInterned[i] != NULL);
+      ASSURE(strcmp(apcInterned[i], acKey) == 0);
+      ASSURE(SymTablePool_intern(oPool, acKey) == apcInterned[i]);
+      SymTablePool_release(oPool, apcInterned[i]);
+      ASSURE(SymTable_get(oSymTable1, apcInterned[i]) == oSymTable1);
+      ASSURE(SymTable_getHashed(oSymTable2, apcInterned[i],
+         SymTablePool_keyOf(oPool, apcInterned[i])) == oSymTable2);
+      ASSURE(SymTable_getHashed(oSymTable2, acKey,
+         SymTable_hashKey(oSymTable2, acKey)) == oSymTable2);
    }
-   
-#ifndef S_SPLINT_S
-   setCpuTimeLimit();
+   ASSURE(SymTablePool_getLength(oPool) == KEY_COUNT);
+
+   iSuccessful = SymTable_begin(oSymTable1, &oIterator);
+   ASSURE(iSuccessful);
+   ASSURE(SymTablePool_intern(oPool, SymTable_key(&oIterator))
+      == SymTable_key(&oIterator));
+   SymTablePool_release(oPool, SymTable_key(&oIterator));
+
+   /* A key stays in the pool until no table or caller refers to
+      it. */
+   for (i = 0; i < KEY_COUNT; i++)
+      if (i != 1)
+         SymTablePool_release(oPool, apcInterned[i]);
+   ASSURE(SymTablePool_getLength(oPool) == KEY_COUNT);
+   ASSURE(SymTable_remove(oSymTable1, "0") == oSymTable1);
+   ASSURE(SymTablePool_getLength(oPool) == KEY_COUNT);
+   ASSURE(SymTable_remove(oSymTable2, apcInterned[0]) == oSymTable2);
+   ASSURE(SymTablePool_getLength(oPool) == KEY_COUNT - 1);
+   ASSURE(SymTable_remove(oSymTable2, "0") == NULL);
+
+   SymTable_free(oSymTable1);
+   ASSURE(SymTablePool_getLength(oPool) == KEY_COUNT - 1);
+   SymTable_free(oSymTable2);
+   ASSURE(SymTablePool_getLength(oPool) == 1);
+   SymTablePool_release(oPool, apcInterned[1]);
+   ASSURE(SymTablePool_getLength(oPool) == 0);
+
+   SymTablePool_free(oPool);
+}
 #endif
 
-   testBasics();
-   testKeyComparison();
-   testKeyOwnership();
+/*--------------------------------------------------------------------*/
+
+#ifdef HAS_SCOPES
+/* Test SymTable objects created by SymTable_newScoped(), and the
+   SymTable_enterScope() and SymTable_exitScope() functions. */
+
+static void testScopes(void)
+{
+   enum {BINDING_COUNT = 2000, SCOPE_COUNT = 100, MAX_KEY_LENGTH = 12};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   char acOuter[] = "outer";
+   char acMiddle[] = "middle";
+   char acInner[] = "inner";
+   int aiDepths[SCOPE_COUNT];
+   int i;
+   int iCount;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_enterScope() and SymTable_exitScope().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_newScoped();
+   ASSURE(oSymTable != NULL);
+
+   iSuccessful = SymTable_put(oSymTable, "x", acOuter);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "y", acOuter);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "x", acMiddle);
+   ASSURE(! iSuccessful);
+
+   /* An inner scope may bind a key again, but only once. */
+   SymTable_enterScope(oSymTable);
+   iSuccessful = SymTable_put(oSymTable, "x", acMiddle);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "x", acInner);
+   ASSURE(! iSuccessful);
+   ASSURE(SymTable_get(oSymTable, "x") == acMiddle);
+   ASSURE(SymTable_get(oSymTable, "y") == acOuter);
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+   iCount = 0;
+   SymTable_map(oSymTable, countBinding, &iCount);
+   ASSURE(iCount == 2);
+
+   /* Removing a binding reveals the one it hid, and leaving a scope
+      undoes only that scope's bindings. */
+   SymTable_enterScope(oSymTable);
+   iSuccessful = SymTable_put(oSymTable, "y", acInner);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "z", acInner);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getLength(oSymTable) == 3);
+   ASSURE(SymTable_remove(oSymTable, "x") == acMiddle);
+   ASSURE(SymTable_get(oSymTable, "x") == acOuter);
+   ASSURE(SymTable_getLength(oSymTable) == 3);
+   SymTable_exitScope(oSymTable);
+   ASSURE(SymTable_get(oSymTable, "x") == acOuter);
+   ASSURE(SymTable_get(oSymTable, "y") == acOuter);
+   ASSURE(! SymTable_contains(oSymTable, "z"));
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+   SymTable_exitScope(oSymTable);
+   ASSURE(SymTable_get(oSymTable, "x") == acOuter);
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+
+   /* A scope whose bindings expand the table hides and then reveals
+      every outer binding. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acOuter);
+      ASSURE(iSuccessful);
+   }
+   SymTable_enterScope(oSymTable);
+   for (i = 0; i < 2 * BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acInner);
+      ASSURE(iSuccessful);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == 2 * BINDING_COUNT + 2);
+   for (i = 0; i < 2 * BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_get(oSymTable, acKey) == acInner);
+   }
+   SymTable_exitScope(oSymTable);
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT + 2);
+   for (i = 0; i < 2 * BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_get(oSymTable, acKey)
+         == (i < BINDING_COUNT ? acOuter : NULL));
+   }
+
+   /* Deeply nested scopes each bind the same key. */
+   for (i = 0; i < SCOPE_COUNT; i++)
+   {
+      SymTable_enterScope(oSymTable);
+      iSuccessful = SymTable_put(oSymTable, "depth", &aiDepths[i]);
+      ASSURE(iSuccessful);
+   }
+   for (i = SCOPE_COUNT - 1; i >= 0; i--)
+   {
+      ASSURE(SymTable_get(oSymTable, "depth") == &aiDepths[i]);
+      SymTable_exitScope(oSymTable);
+   }
+   ASSURE(! SymTable_contains(oSymTable, "depth"));
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT + 2);
+
+   SymTable_free(oSymTable);
+}
+#endif
+
+/*--------------------------------------------------------------------*/
+
+#ifdef HAS_SNAPSHOT
+/* Test the SymTable_snapshot() function. */
+
+static void testSnapshots(void)
+{
+   enum {BINDING_COUNT = 2000, MAX_KEY_LENGTH = 12};
+
+   SymTable_T oSymTable;
+   SymTable_T oSnapshot;
+   SymTable_T oSecond;
+   char acKey[MAX_KEY_LENGTH];
+   char acOld[] = "old";
+   char acNew[] = "new";
+   int i;
+   int iCount;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_snapshot().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* A snapshot of an empty table is empty. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   oSnapshot = SymTable_snapshot(oSymTable);
+   ASSURE(oSnapshot != NULL);
+   ASSURE(SymTable_getLength(oSnapshot) == 0);
+   iSuccessful = SymTable_put(oSymTable, "key", acNew);
+   ASSURE(iSuccessful);
+   ASSURE(! SymTable_contains(oSnapshot, "key"));
+   SymTable_free(oSnapshot);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acOld);
+      ASSURE(iSuccessful);
+   }
+   oSnapshot = SymTable_snapshot(oSymTable);
+   ASSURE(oSnapshot != NULL);
+   ASSURE(SymTable_getLength(oSnapshot) == BINDING_COUNT + 1);
+
+   /* Changing the table leaves the snapshot as it was. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      if (i % 3 == 0)
+      {
+         ASSURE(SymTable_remove(oSymTable, acKey) == acOld);
+      }
+      else if (i % 3 == 1)
+      {
+         ASSURE(SymTable_replace(oSymTable, acKey, acNew) == acOld);
+      }
+   }
+   for (i = BINDING_COUNT; i < 2 * BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acNew);
+      ASSURE(iSuccessful);
+   }
+   ASSURE(SymTable_getLength(oSnapshot) == BINDING_COUNT + 1);
+   for (i = 0; i < 2 * BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_get(oSnapshot, acKey)
+         == (i < BINDING_COUNT ? acOld : NULL));
+   }
+   iCount = 0;
+   SymTable_map(oSnapshot, countBinding, &iCount);
+   ASSURE(iCount == BINDING_COUNT + 1);
+
+   /* Changing the snapshot leaves the table as it was, and a snapshot
+      of a snapshot is independent of both. */
+   oSecond = SymTable_snapshot(oSnapshot);
+   ASSURE(oSecond != NULL);
+   iSuccessful = SymTable_put(oSnapshot, "extra", acNew);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_remove(oSnapshot, "key") == acNew);
+   ASSURE(! SymTable_contains(oSymTable, "extra"));
+   ASSURE(SymTable_get(oSymTable, "key") == acNew);
+   ASSURE(! SymTable_contains(oSecond, "extra"));
+   ASSURE(SymTable_get(oSecond, "key") == acNew);
+   ASSURE(SymTable_getLength(oSecond) == BINDING_COUNT + 1);
+
+   /* The tables may be freed in any order. */
+   SymTable_free(oSnapshot);
+   for (i = 0; i < 2 * BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      if (i < BINDING_COUNT && i % 3 == 0)
+      {
+         ASSURE(! SymTable_contains(oSymTable, acKey));
+      }
+      else
+      {
+         ASSURE(SymTable_get(oSymTable, acKey)
+            == (i % 3 == 2 && i < BINDING_COUNT ? acOld : acNew));
+      }
+      ASSURE(SymTable_get(oSecond, acKey)
+         == (i < BINDING_COUNT ? acOld : NULL));
+   }
+   SymTable_free(oSymTable);
+   ASSURE(SymTable_getLength(oSecond) == BINDING_COUNT + 1);
+   ASSURE(SymTable_get(oSecond, "0") == acOld);
+   SymTable_free(oSecond);
+}
+#endif
+
+/*--------------------------------------------------------------------*/
+
+#ifdef HAS_CLONE
+#ifdef COUNT_ALLOCATIONS
+/* Clone oSymTable, change a binding of the clone and then one of
+   oSymTable while the clone exists, free the clone, and change
+   another binding of oSymTable, as a server that clones a long-lived
+   table for each request does. */
+
+static void cloneForRequest(SymTable_T oSymTable, char *pcValue)
+{
+   SymTable_T oClone;
+
+   oClone = SymTable_clone(oSymTable);
+   ASSURE(oClone != NULL);
+   ASSURE(SymTable_replace(oClone, "7", pcValue) != NULL);
+   ASSURE(SymTable_replace(oSymTable, "8", pcValue) != NULL);
+   SymTable_free(oClone);
+   ASSURE(SymTable_replace(oSymTable, "9", pcValue) != NULL);
+}
+
+/*--------------------------------------------------------------------*/
+#endif
+
+/* Test the SymTable_clone() function. */
+
+static void testClone(void)
+{
+   enum {BINDING_COUNT = 2000, SMALL_COUNT = 3, MAX_KEY_LENGTH = 12,
+      ROUND_COUNT = 5000};
+
+   SymTable_T oSymTable;
+   SymTable_T oClone;
+   SymTable_T oSecond;
+   char acKey[MAX_KEY_LENGTH];
+   char acOld[] = "old";
+   char acNew[] = "new";
+   int i;
+   int iCount;
+   int iSuccessful;
+#ifdef COUNT_ALLOCATIONS
+   unsigned long ulRound;
+   unsigned long ulInitial;
+#endif
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_clone().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* A clone of a small table is independent of it. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < SMALL_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acOld);
+      ASSURE(iSuccessful);
+   }
+   oClone = SymTable_clone(oSymTable);
+   ASSURE(oClone != NULL);
+   ASSURE(SymTable_getLength(oClone) == SMALL_COUNT);
+   ASSURE(SymTable_replace(oClone, "0", acNew) == acOld);
+   ASSURE(SymTable_get(oSymTable, "0") == acOld);
+   SymTable_free(oSymTable);
+   ASSURE(SymTable_get(oClone, "0") == acNew);
+   SymTable_free(oClone);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acOld);
+      ASSURE(iSuccessful);
+   }
+   oClone = SymTable_clone(oSymTable);
+   ASSURE(oClone != NULL);
+   ASSURE(SymTable_getLength(oClone) == BINDING_COUNT);
+
+   /* Changing the clone leaves the table as it was, even once the
+      clone expands. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      if (i % 3 == 0)
+      {
+         ASSURE(SymTable_remove(oClone, acKey) == acOld);
+      }
+      else if (i % 3 == 1)
+      {
+         ASSURE(SymTable_replace(oClone, acKey, acNew) == acOld);
+      }
+   }
+   for (i = BINDING_COUNT; i < 2 * BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oClone, acKey, acNew);
+      ASSURE(iSuccessful);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT);
+   for (i = 0; i < 2 * BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_get(oSymTable, acKey)
+         == (i < BINDING_COUNT ? acOld : NULL));
+   }
+   iCount = 0;
+   SymTable_map(oSymTable, countBinding, &iCount);
+   ASSURE(iCount == BINDING_COUNT);
+
+   /* Changing the table leaves its clones as they were, and a clone
+      of a clone is independent of both. */
+   oSecond = SymTable_clone(oClone);
+   ASSURE(oSecond != NULL);
+   iSuccessful = SymTable_put(oSymTable, "extra", acNew);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_remove(oSymTable, "1") == acOld);
+   ASSURE(SymTable_replace(oSymTable, "2", acNew) == acOld);
+   ASSURE(SymTable_remove(oSecond, "2") == acOld);
+   ASSURE(! SymTable_contains(oClone, "extra"));
+   ASSURE(SymTable_get(oClone, "1") == acNew);
+   ASSURE(SymTable_get(oClone, "2") == acOld);
+   ASSURE(SymTable_get(oSecond, "1") == acNew);
+   ASSURE(SymTable_getLength(oSecond) == SymTable_getLength(oClone) - 1);
+
+   /* The tables may be freed in any order. */
+   SymTable_free(oClone);
+   for (i = 0; i < 2 * BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      if (i == 2 || (i < BINDING_COUNT && i % 3 == 0))
+      {
+         ASSURE(! SymTable_contains(oSecond, acKey));
+      }
+      else
+      {
+         ASSURE(SymTable_get(oSecond, acKey)
+            == (i % 3 == 2 && i < BINDING_COUNT ? acOld : acNew));
+      }
+   }
+   SymTable_free(oSecond);
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT);
+   ASSURE(SymTable_get(oSymTable, "extra") == acNew);
+   ASSURE(SymTable_get(oSymTable, "2") == acNew);
+
+#ifdef COUNT_ALLOCATIONS
+   /* Cloning a table and freeing the clone, again and again, leaves
+      the table's memory bounded: once the table and its clones have
+      warmed up, every round makes the same allocations, and none of
+      them grows the arena. */
+   for (i = 0; i < SMALL_COUNT; i++)
+   {
+      cloneForRequest(oSymTable, i % 2 == 0 ? acNew : acOld);
+   }
+   ulInitial = ulAllocationCount;
+   cloneForRequest(oSymTable, acNew);
+   ulRound = ulAllocationCount - ulInitial;
+   ulInitial = ulAllocationCount;
+   for (i = 0; i < ROUND_COUNT; i++)
+   {
+      cloneForRequest(oSymTable, i % 2 == 0 ? acOld : acNew);
+   }
+   ASSURE(ulAllocationCount - ulInitial == ROUND_COUNT * ulRound);
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT);
+#endif
+
+   /* Expanding a table whose chains a clone still shares copies them,
+      and leaves the clone as it was. */
+   oClone = SymTable_clone(oSymTable);
+   ASSURE(oClone != NULL);
+   for (i = 2 * BINDING_COUNT; i < 6 * BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acNew);
+      ASSURE(iSuccessful);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == 5 * BINDING_COUNT);
+   ASSURE(SymTable_getLength(oClone) == BINDING_COUNT);
+   for (i = 0; i < 6 * BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      if (i < 2 * BINDING_COUNT)
+      {
+         ASSURE(SymTable_get(oClone, acKey)
+            == SymTable_get(oSymTable, acKey));
+      }
+      else
+      {
+         ASSURE(! SymTable_contains(oClone, acKey));
+         ASSURE(SymTable_get(oSymTable, acKey) == acNew);
+      }
+   }
+   ASSURE(SymTable_replace(oClone, "2", acOld) == acNew);
+   ASSURE(SymTable_remove(oSymTable, "3") == acOld);
+   ASSURE(SymTable_get(oSymTable, "2") == acNew);
+   ASSURE(SymTable_get(oClone, "3") == acOld);
+   SymTable_free(oSymTable);
+   ASSURE(SymTable_getLength(oClone) == BINDING_COUNT);
+   ASSURE(SymTable_get(oClone, "extra") == acNew);
+   iCount = 0;
+   SymTable_map(oClone, countBinding, &iCount);
+   ASSURE(iCount == BINDING_COUNT);
+   SymTable_free(oClone);
+}
+#endif
+
+/*--------------------------------------------------------------------*/
+
+#ifdef HAS_SAVE
+/* Return the number of bytes of the string pvValue, including its
+   terminating nul. */
+
+static size_t stringSize(const void *pvValue)
+{
+   return strlen((const char*)pvValue) + 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_save() and SymTable_loadMapped() functions. */
+
+static void testSaveAndLoad(void)
+{
+   enum {BINDING_COUNT = 2000, MAX_KEY_LENGTH = 12};
+
+   const char *pcFilename = "testsymtable.img";
+   const char *apcValues[] = {"", "Shortstop", "Center Field"};
+   SymTable_T oSymTable;
+   SymTable_T oLoaded;
+   char acKey[MAX_KEY_LENGTH];
+   char *pcValue;
+   FILE *psFile;
+   int i;
+   int iCount;
+   int iSuccessful;
+#ifdef HAS_ITERATOR
+   SymTable_Iterator oIterator;
+#endif
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_save() and SymTable_loadMapped().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* An empty table loads as an empty table. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTable_save(oSymTable, pcFilename, stringSize);
+   ASSURE(iSuccessful);
+   oLoaded = SymTable_loadMapped(pcFilename);
+   ASSURE(oLoaded != NULL);
+   ASSURE(SymTable_getLength(oLoaded) == 0);
+   ASSURE(! SymTable_contains(oLoaded, ""));
+   SymTable_free(oLoaded);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, apcValues[i % 3]);
+      ASSURE(iSuccessful);
+   }
+   iSuccessful = SymTable_put(oSymTable, "", NULL);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_save(oSymTable, pcFilename, stringSize);
+   ASSURE(iSuccessful);
+   SymTable_free(oSymTable);
+
+   /* The loaded table has copies of the saved values, each aligned. */
+   oLoaded = SymTable_loadMapped(pcFilename);
+   ASSURE(oLoaded != NULL);
+   ASSURE(SymTable_getLength(oLoaded) == BINDING_COUNT + 1);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      pcValue = (char*)SymTable_get(oLoaded, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE(pcValue != apcValues[i % 3]);
+      ASSURE(strcmp(pcValue, apcValues[i % 3]) == 0);
+      ASSURE((size_t)pcValue % 16 == 0);
+   }
+   ASSURE(SymTable_contains(oLoaded, ""));
+   ASSURE(SymTable_get(oLoaded, "") == NULL);
+   ASSURE(! SymTable_contains(oLoaded, "-1"));
+   ASSURE(SymTable_get(oLoaded, "Ruth") == NULL);
+   iCount = 0;
+   SymTable_map(oLoaded, countBinding, &iCount);
+   ASSURE(iCount == BINDING_COUNT + 1);
+#ifdef HAS_ITERATOR
+   iCount = 0;
+   if (SymTable_begin(oLoaded, &oIterator))
+   {
+      do
+      {
+         ASSURE(SymTable_get(oLoaded, SymTable_key(&oIterator))
+            == SymTable_value(&oIterator));
+         iCount++;
+      } while (SymTable_next(oLoaded, &oIterator));
+   }
+   ASSURE(iCount == BINDING_COUNT + 1);
+#endif
+
+   /* Saving over a loaded image leaves the loaded table as it was. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTable_put(oSymTable, "Ruth", "Right Field");
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_save(oSymTable, pcFilename, stringSize);
+   ASSURE(iSuccessful);
+   SymTable_free(oSymTable);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      pcValue = (char*)SymTable_get(oLoaded, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE(strcmp(pcValue, apcValues[i % 3]) == 0);
+   }
+   SymTable_free(oLoaded);
+   oLoaded = SymTable_loadMapped(pcFilename);
+   ASSURE(oLoaded != NULL);
+   ASSURE(SymTable_getLength(oLoaded) == 1);
+   ASSURE(strcmp((char*)SymTable_get(oLoaded, "Ruth"), "Right Field") == 0);
+   SymTable_free(oLoaded);
+
+   /* An image whose last byte is changed, so that its last key might
+      not end within it, does not load. */
+   psFile = fopen(pcFilename, "r+b");
+   ASSURE(psFile != NULL);
+   ASSURE(fseek(psFile, -1L, SEEK_END) == 0);
+   ASSURE(fputc('x', psFile) == 'x');
+   fclose(psFile);
+   ASSURE(SymTable_loadMapped(pcFilename) == NULL);
+
+   /* A file that is not an image, or no file at all, does not load. */
+   psFile = fopen(pcFilename, "w");
+   ASSURE(psFile != NULL);
+   fprintf(psFile, "%s\n", "This file is not an image of a SymTable object.");
+   fclose(psFile);
+   ASSURE(SymTable_loadMapped(pcFilename) == NULL);
+   remove(pcFilename);
+   ASSURE(SymTable_loadMapped(pcFilename) == NULL);
+}
+#endif
+
+/*--------------------------------------------------------------------*/
+
+#ifdef HAS_FREEZE
+/* Test the SymTable_freeze() function. */
+
+static void testFreeze(void)
+{
+   enum {BINDING_COUNT = 20000, MAX_KEY_LENGTH = 12};
+
+   const char *apcValues[] = {"", "Shortstop", "Center Field"};
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   int i;
+   int iCount;
+   int iSuccessful;
+#ifdef HAS_ITERATOR
+   SymTable_Iterator oIterator;
+#endif
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_freeze().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* An empty table freezes into an empty table. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTable_freeze(oSymTable);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   ASSURE(! SymTable_contains(oSymTable, ""));
+   ASSURE(SymTable_get(oSymTable, "Ruth") == NULL);
+   iCount = 0;
+   SymTable_map(oSymTable, countBinding, &iCount);
+   ASSURE(iCount == 0);
+   SymTable_free(oSymTable);
+
+   /* So does a table still in its small array. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTable_put(oSymTable, "Ruth", apcValues[1]);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_freeze(oSymTable);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getLength(oSymTable) == 1);
+   ASSURE(SymTable_get(oSymTable, "Ruth") == apcValues[1]);
+   ASSURE(! SymTable_contains(oSymTable, "Gehrig"));
+   SymTable_free(oSymTable);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, apcValues[i % 3]);
+      ASSURE(iSuccessful);
+   }
+   iSuccessful = SymTable_put(oSymTable, "", NULL);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_freeze(oSymTable);
+   ASSURE(iSuccessful);
+
+   /* The frozen table has every binding, and only those. */
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT + 1);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_get(oSymTable, acKey) == apcValues[i % 3]);
+      ASSURE(SymTable_contains(oSymTable, acKey));
+#ifdef HAS_HASHED_KEYS
+      ASSURE(SymTable_getHashed(oSymTable, acKey,
+         SymTable_hashKey(oSymTable, acKey)) == apcValues[i % 3]);
+#endif
+   }
+   ASSURE(SymTable_contains(oSymTable, ""));
+   ASSURE(SymTable_get(oSymTable, "") == NULL);
+   for (i = BINDING_COUNT; i < 2 * BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(! SymTable_contains(oSymTable, acKey));
+   }
+   ASSURE(SymTable_get(oSymTable, "Ruth") == NULL);
+   iCount = 0;
+   SymTable_map(oSymTable, countBinding, &iCount);
+   ASSURE(iCount == BINDING_COUNT + 1);
+#ifdef HAS_ITERATOR
+   iCount = 0;
+   if (SymTable_begin(oSymTable, &oIterator))
+   {
+      do
+      {
+         ASSURE(SymTable_get(oSymTable, SymTable_key(&oIterator))
+            == SymTable_value(&oIterator));
+         iCount++;
+      } while (SymTable_next(oSymTable, &oIterator));
+   }
+   ASSURE(iCount == BINDING_COUNT + 1);
+#endif
+
+   /* Freezing a frozen table does nothing. */
+   iSuccessful = SymTable_freeze(oSymTable);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT + 1);
+   ASSURE(SymTable_get(oSymTable, "1") == apcValues[1]);
+   SymTable_free(oSymTable);
+
+#ifdef HAS_SCOPES
+   /* A scoped table keeps only its innermost bindings. */
+   oSymTable = SymTable_newScoped();
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTable_put(oSymTable, "Ruth", apcValues[1]);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "Gehrig", apcValues[1]);
+   ASSURE(iSuccessful);
+   SymTable_enterScope(oSymTable);
+   iSuccessful = SymTable_put(oSymTable, "Ruth", apcValues[2]);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_freeze(oSymTable);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+   ASSURE(SymTable_get(oSymTable, "Ruth") == apcValues[2]);
+   ASSURE(SymTable_get(oSymTable, "Gehrig") == apcValues[1]);
+   SymTable_free(oSymTable);
+#endif
+}
+#endif
+
+/*--------------------------------------------------------------------*/
+
+#ifdef COUNT_ALLOCATIONS
+/* Test that lookups, and puts that find their key already bound,
+   make no heap allocations. Write the number of allocations per
+   call of each function to stdout. */
+
+static void testAllocations(void)
+{
+   enum {BINDING_COUNT = 1000, MAX_KEY_LENGTH = 12};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   char acShortstop[] = "Shortstop";
+   int i;
+   int iSuccessful;
+   unsigned long ulGet;
+   unsigned long ulGetMissing;
+   unsigned long ulContains;
+   unsigned long ulReplace;
+   unsigned long ulRemoveMissing;
+   unsigned long ulPutDuplicate;
+   unsigned long ulInitial;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing heap allocations made by lookups.\n");
+   printf("Only allocations per call, all zero, should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acShortstop);
+      ASSURE(iSuccessful);
+   }
+
+   ulInitial = ulAllocationCount;
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_get(oSymTable, acKey) == acShortstop);
+   }
+   ulGet = ulAllocationCount - ulInitial;
+
+   ulInitial = ulAllocationCount;
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", -1 - i);
+      ASSURE(SymTable_get(oSymTable, acKey) == NULL);
+   }
+   ulGetMissing = ulAllocationCount - ulInitial;
+
+   ulInitial = ulAllocationCount;
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_contains(oSymTable, acKey));
+   }
+   ulContains = ulAllocationCount - ulInitial;
+
+   ulInitial = ulAllocationCount;
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_replace(oSymTable, acKey, acShortstop)
+         == acShortstop);
+   }
+   ulReplace = ulAllocationCount - ulInitial;
+
+   ulInitial = ulAllocationCount;
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", -1 - i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == NULL);
+   }
+   ulRemoveMissing = ulAllocationCount - ulInitial;
+
+   ulInitial = ulAllocationCount;
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acShortstop);
+      ASSURE(! iSuccessful);
+   }
+   ulPutDuplicate = ulAllocationCount - ulInitial;
+
+   SymTable_free(oSymTable);
+
+   printf("SymTable_get:                %f allocations per call\n",
+      (double)ulGet / BINDING_COUNT);
+   printf("SymTable_get (missing key):  %f allocations per call\n",
+      (double)ulGetMissing / BINDING_COUNT);
+   printf("SymTable_contains:           %f allocations per call\n",
+      (double)ulContains / BINDING_COUNT);
+   printf("SymTable_replace:            %f allocations per call\n",
+      (double)ulReplace / BINDING_COUNT);
+   printf("SymTable_remove (missing):   %f allocations per call\n",
+      (double)ulRemoveMissing / BINDING_COUNT);
+   printf("SymTable_put (duplicate):    %f allocations per call\n",
+      (double)ulPutDuplicate / BINDING_COUNT);
+   fflush(stdout);
+
+   ASSURE(ulGet == 0);
+   ASSURE(ulGetMissing == 0);
+   ASSURE(ulContains == 0);
+   ASSURE(ulReplace == 0);
+   ASSURE(ulRemoveMissing == 0);
+   ASSURE(ulPutDuplicate == 0);
+}
+#endif
+
+/*--------------------------------------------------------------------*/
+
+#ifdef HAS_GET_MANY
+/* Test the SymTable_getMany() and SymTable_containsMany() functions
+   on a SymTable object that contains iBindingCount bindings. Write
+   the time consumed by looking up every key in a scattered order,
+   first by calling SymTable_get() in a loop and then by calling
+   SymTable_getMany(), to stdout. */
+
+static void testGetMany(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 12, BATCH = 64, STRIDE = 7919};
+
+   SymTable_T oSymTable;
+   char *pcKeyText;
+   const char **ppcKeys;
+   const char *apcBatch[BATCH];
+   void *apvValues[BATCH];
+   int aiFound[BATCH];
+   size_t uKeyCount;
+   size_t uStart;
+   size_t uBatch;
+   size_t u;
+   size_t v;
+   size_t uMismatches = 0;
+   int iSuccessful;
+   clock_t iInitialClock;
+   clock_t iLoopClock;
+   clock_t iFinalClock;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_getMany() and SymTable_containsMany().\n");
+   printf("No output except CPU time consumed should appear here:\n");
+   fflush(stdout);
+
+   /* Keys 0 through iBindingCount - 1 are bound, and the next quarter
+      as many keys are looked up but not bound. */
+   uKeyCount = (size_t)iBindingCount + (size_t)iBindingCount / 4 + 1;
+   pcKeyText = (char*)malloc(uKeyCount * MAX_KEY_LENGTH);
+   ppcKeys = (const char**)malloc(uKeyCount * sizeof(const char*));
+   ASSURE(pcKeyText != NULL && ppcKeys != NULL);
+   if (pcKeyText == NULL || ppcKeys == NULL)
+   {
+      free(pcKeyText);
+      free(ppcKeys);
+      return;
+   }
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (u = 0; u < uKeyCount; u++)
+   {
+      sprintf(pcKeyText + u * MAX_KEY_LENGTH, "%lu", (unsigned long)u);
+      ppcKeys[u] = pcKeyText + u * MAX_KEY_LENGTH;
+      if (u < (size_t)iBindingCount)
+      {
+         iSuccessful = SymTable_put(oSymTable, ppcKeys[u], ppcKeys[u]);
+         ASSURE(iSuccessful);
+      }
+   }
+
+   /* Visit the keys in a scattered order, so that consecutive
+      lookups do not touch neighboring memory. */
+   iInitialClock = clock();
+   for (uStart = 0; uStart < uKeyCount; uStart += BATCH)
+   {
+      uBatch = uKeyCount - uStart < BATCH ? uKeyCount - uStart : BATCH;
+      for (v = 0; v < uBatch; v++)
+      {
+         apcBatch[v] = ppcKeys[((uStart + v) * STRIDE) % uKeyCount];
+         apvValues[v] = SymTable_get(oSymTable, apcBatch[v]);
+      }
+      for (v = 0; v < uBatch; v++)
+         if (apvValues[v] != ((apcBatch[v] - pcKeyText) / MAX_KEY_LENGTH
+               < iBindingCount ? apcBatch[v] : NULL))
+            uMismatches++;
+   }
+   iLoopClock = clock();
+   for (uStart = 0; uStart < uKeyCount; uStart += BATCH)
+   {
+      uBatch = uKeyCount - uStart < BATCH ? uKeyCount - uStart : BATCH;
+      for (v = 0; v < uBatch; v++)
+         apcBatch[v] = ppcKeys[((uStart + v) * STRIDE) % uKeyCount];
+      SymTable_getMany(oSymTable, apcBatch, uBatch, apvValues);
+      for (v = 0; v < uBatch; v++)
+         if (apvValues[v] != ((apcBatch[v] - pcKeyText) / MAX_KEY_LENGTH
+               < iBindingCount ? apcBatch[v] : NULL))
+            uMismatches++;
+   }
+   iFinalClock = clock();
+   ASSURE(uMismatches == 0);
+
+   SymTable_containsMany(oSymTable, ppcKeys + uKeyCount - 2, 2, aiFound);
+   ASSURE(! aiFound[0] && ! aiFound[1]);
+   if (iBindingCount > 0)
+   {
+      SymTable_containsMany(oSymTable, ppcKeys, 1, aiFound);
+      ASSURE(aiFound[0]);
+   }
+   SymTable_getMany(oSymTable, ppcKeys, 0, apvValues);
+
+   SymTable_free(oSymTable);
+   free(ppcKeys);
+   free(pcKeyText);
+
+   printf("CPU time (%d bindings, SymTable_get):      %f seconds\n",
+      iBindingCount,
+      ((double)(iLoopClock - iInitialClock)) / CLOCKS_PER_SEC);
+   printf("CPU time (%d bindings, SymTable_getMany):  %f seconds\n",
+      iBindingCount,
+      ((double)(iFinalClock - iLoopClock)) / CLOCKS_PER_SEC);
+   fflush(stdout);
+}
+#endif
+
+/*--------------------------------------------------------------------*/
+
+#if defined(HAS_SORTED_MAP) || defined(HAS_ORDERED_MAP)
+enum {MAX_ORDER_KEY_LENGTH = 80};
+
+/* What checkOrder() has seen of the bindings it was applied to */
+
+struct Order
+{
+   /* The key of the previous binding, or NULL before the first */
+   const char *pcPrevious;
+   /* A copy of that key, since SymTable_map() need not keep pcKey
+      valid once checkOrder() returns */
+   char acPrevious[MAX_ORDER_KEY_LENGTH];
+   /* The number of bindings */
+   int iCount;
+   /* The number of bindings whose key was not greater than the key
+      of the previous binding */
+   int iOutOfOrder;
+};
+
+/* Add the binding whose key is pcKey to *pvOrder, a struct Order. */
+
+static void checkOrder(const char *pcKey, void *pvValue, void *pvOrder)
+{
+   struct Order *psOrder = (struct Order*)pvOrder;
+
+   assert(pcKey != NULL);
+   assert(pvOrder != NULL);
+   (void)pvValue;
+
+   if (psOrder->pcPrevious != NULL
+         && strcmp(psOrder->pcPrevious, pcKey) >= 0)
+      psOrder->iOutOfOrder++;
+   ASSURE(strlen(pcKey) < MAX_ORDER_KEY_LENGTH);
+   strncpy(psOrder->acPrevious, pcKey, MAX_ORDER_KEY_LENGTH - 1);
+   psOrder->acPrevious[MAX_ORDER_KEY_LENGTH - 1] = '\0';
+   psOrder->pcPrevious = psOrder->acPrevious;
+   psOrder->iCount++;
+}
+#endif
+
+#ifdef HAS_ORDERED_MAP
+
+/* Test that SymTable_map() visits bindings in ascending key order,
+   and test the SymTable_mapRange() and SymTable_mapPrefix()
+   functions. */
+
+static void testOrderedMap(void)
+{
+   enum {BINDING_COUNT = 1000, MAX_KEY_LENGTH = 16};
+
+   SymTable_T oSymTable;
+   struct Order sOrder;
+   char acKey[MAX_KEY_LENGTH];
+   int i;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_mapRange() and SymTable_mapPrefix().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* Put keys "foo_0" through "foo_999" and "bar_0" through "bar_999"
+      in a scattered order. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "foo_%d", (i * 7) % BINDING_COUNT);
+      iSuccessful = SymTable_put(oSymTable, acKey, "foo");
+      ASSURE(iSuccessful);
+      sprintf(acKey, "bar_%d", (i * 13) % BINDING_COUNT);
+      iSuccessful = SymTable_put(oSymTable, acKey, "bar");
+      ASSURE(iSuccessful);
+   }
+   iSuccessful = SymTable_put(oSymTable, "foo", "foo");
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "fop", "fop");
+   ASSURE(iSuccessful);
+
+   sOrder.pcPrevious = NULL;
+   sOrder.iCount = 0;
+   sOrder.iOutOfOrder = 0;
+   SymTable_map(oSymTable, checkOrder, &sOrder);
+   ASSURE(sOrder.iCount == 2 * BINDING_COUNT + 2);
+   ASSURE(sOrder.iOutOfOrder == 0);
+
+   /* "foo_" precedes every key that begins with it, and "foo`"
+      follows them. */
+   sOrder.pcPrevious = NULL;
+   sOrder.iCount = 0;
+   SymTable_mapPrefix(oSymTable, "foo_", checkOrder, &sOrder);
+   ASSURE(sOrder.iCount == BINDING_COUNT);
+   ASSURE(sOrder.iOutOfOrder == 0);
+
+   sOrder.pcPrevious = NULL;
+   sOrder.iCount = 0;
+   SymTable_mapRange(oSymTable, "foo_", "foo`", checkOrder, &sOrder);
+   ASSURE(sOrder.iCount == BINDING_COUNT);
+   ASSURE(sOrder.iOutOfOrder == 0);
+
+   /* The low end of a range is included and the high end is not. */
+   sOrder.pcPrevious = NULL;
+   sOrder.iCount = 0;
+   SymTable_mapRange(oSymTable, "bar_10", "bar_11", checkOrder, &sOrder);
+   ASSURE(sOrder.iCount == 11);
+
+   /* The prefix "foo" matches the key "foo" and every "foo_" key. */
+   sOrder.pcPrevious = NULL;
+   sOrder.iCount = 0;
+   SymTable_mapPrefix(oSymTable, "foo", checkOrder, &sOrder);
+   ASSURE(sOrder.iCount == BINDING_COUNT + 1);
+
+   /* Open ends, empty ranges, and absent prefixes. */
+   sOrder.pcPrevious = NULL;
+   sOrder.iCount = 0;
+   SymTable_mapRange(oSymTable, NULL, "foo", checkOrder, &sOrder);
+   ASSURE(sOrder.iCount == BINDING_COUNT);
+   sOrder.pcPrevious = NULL;
+   sOrder.iCount = 0;
+   SymTable_mapRange(oSymTable, "fop", NULL, checkOrder, &sOrder);
+   ASSURE(sOrder.iCount == 1);
+   sOrder.iCount = 0;
+   SymTable_mapRange(oSymTable, "z", "a", checkOrder, &sOrder);
+   SymTable_mapPrefix(oSymTable, "baz", checkOrder, &sOrder);
+   ASSURE(sOrder.iCount == 0);
+   sOrder.pcPrevious = NULL;
+   SymTable_mapPrefix(oSymTable, "", checkOrder, &sOrder);
+   ASSURE(sOrder.iCount == 2 * BINDING_COUNT + 2);
+
+   /* Removed keys leave the order intact. */
+   for (i = 0; i < BINDING_COUNT; i += 2)
+   {
+      sprintf(acKey, "bar_%d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) != NULL);
+   }
+   sOrder.pcPrevious = NULL;
+   sOrder.iCount = 0;
+   SymTable_mapPrefix(oSymTable, "bar_", checkOrder, &sOrder);
+   ASSURE(sOrder.iCount == BINDING_COUNT / 2);
+   ASSURE(sOrder.iOutOfOrder == 0);
+
+   SymTable_free(oSymTable);
+}
+#endif
+
+/*--------------------------------------------------------------------*/
+
+#ifdef HAS_ITERATOR
+/* Test the SymTable_begin(), SymTable_next(), SymTable_key(), and
+   SymTable_value() functions. */
+
+static void testIterator(void)
+{
+   enum {BINDING_COUNT = 3000, MAX_KEY_LENGTH = 12};
+
+   SymTable_T oSymTable;
+   SymTable_Iterator oIterator;
+   char acKey[MAX_KEY_LENGTH];
+   char acFirst[] = "first";
+   char acSecond[] = "second";
+   int aiSeen[BINDING_COUNT];
+   int iMore;
+   int iCount;
+   int iKey;
+   int i;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_Iterator functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* An empty table has no first binding. */
+   iMore = SymTable_begin(oSymTable, &oIterator);
+   ASSURE(! iMore);
+   iMore = SymTable_next(oSymTable, &oIterator);
+   ASSURE(! iMore);
+
+   /* Keys are spread over enough buckets to force expansion, and to
+      leave most bitmap words partly empty. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acFirst);
+      ASSURE(iSuccessful);
+      aiSeen[i] = 0;
+   }
+
+   /* Every binding is visited exactly once, and values may be
+      replaced along the way. */
+   iCount = 0;
+   for (iMore = SymTable_begin(oSymTable, &oIterator); iMore;
+        iMore = SymTable_next(oSymTable, &oIterator))
+   {
+      iKey = atoi(SymTable_key(&oIterator));
+      ASSURE(iKey >= 0 && iKey < BINDING_COUNT);
+      if (iKey >= 0 && iKey < BINDING_COUNT)
+         aiSeen[iKey]++;
+      ASSURE(SymTable_value(&oIterator) == acFirst);
+      ASSURE(SymTable_get(oSymTable, SymTable_key(&oIterator))
+         == acFirst);
+      SymTable_replace(oSymTable, SymTable_key(&oIterator), acSecond);
+      ASSURE(SymTable_value(&oIterator) == acSecond);
+      iCount++;
+   }
+   ASSURE(iCount == BINDING_COUNT);
+   for (i = 0; i < BINDING_COUNT; i++)
+      ASSURE(aiSeen[i] == 1);
+
+   /* An iteration that has ended stays ended. */
+   iMore = SymTable_next(oSymTable, &oIterator);
+   ASSURE(! iMore);
+
+   /* An iteration may stop at the first binding that matches. */
+   for (iMore = SymTable_begin(oSymTable, &oIterator); iMore;
+        iMore = SymTable_next(oSymTable, &oIterator))
+      if (strcmp(SymTable_key(&oIterator), "1234") == 0)
+         break;
+   ASSURE(iMore);
+   ASSURE(iMore && strcmp(SymTable_key(&oIterator), "1234") == 0);
+
+   /* Buckets emptied by removal are skipped. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      if (i % 3 != 0)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_remove(oSymTable, acKey) == acSecond);
+      }
+   }
+   iCount = 0;
+   for (iMore = SymTable_begin(oSymTable, &oIterator); iMore;
+        iMore = SymTable_next(oSymTable, &oIterator))
+   {
+      ASSURE(atoi(SymTable_key(&oIterator)) % 3 == 0);
+      iCount++;
+   }
+   ASSURE(iCount == (BINDING_COUNT + 2) / 3);
+
+   SymTable_free(oSymTable);
+}
+#endif
+
+/*--------------------------------------------------------------------*/
+
+#ifdef HAS_MAP_PARALLEL
+/* What testMapParallel() accumulates over the bindings of a SymTable
+   object whose keys are numerals. */
+
+struct MapTotal
+{
+   /* The number of bindings */
+   size_t uCount;
+   /* The sum of the numbers that the keys spell */
+   unsigned long ulKeySum;
+   /* The number of bindings whose value is not the expected one */
+   size_t uWrongValues;
+   /* The expected value of every binding */
+   void *pvValue;
+};
+
+/* Add the binding whose key is pcKey and whose value is pvValue to
+   *pvTotal, a struct MapTotal. */
+
+static void totalBinding(const char *pcKey, void *pvValue,
+   void *pvTotal)
+{
+   struct MapTotal *psTotal = (struct MapTotal*)pvTotal;
+
+   assert(pcKey != NULL);
+   assert(pvTotal != NULL);
+
+   psTotal->uCount++;
+   psTotal->ulKeySum += strtoul(pcKey, NULL, 10);
+   if (pvValue != psTotal->pvValue)
+      psTotal->uWrongValues++;
+}
+
+/* Add *pvPart to *pvTotal, both struct MapTotal. */
+
+static void addTotal(void *pvPart, void *pvTotal)
+{
+   struct MapTotal *psPart = (struct MapTotal*)pvPart;
+   struct MapTotal *psTotal = (struct MapTotal*)pvTotal;
+
+   assert(pvPart != NULL);
+   assert(pvTotal != NULL);
+
+   psTotal->uCount += psPart->uCount;
+   psTotal->ulKeySum += psPart->ulKeySum;
+   psTotal->uWrongValues += psPart->uWrongValues;
+}
+
+/* Test the SymTable_mapParallel() function on a SymTable object that
+   contains iBindingCount bindings, with several numbers of threads. */
+
+static void testMapParallel(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 12, MAX_THREADS = 16};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   struct MapTotal asParts[MAX_THREADS];
+   void *apvParts[MAX_THREADS];
+   struct MapTotal sExpected;
+   struct MapTotal sTotal;
+   size_t auThreads[] = {1, 3, MAX_THREADS};
+   size_t uTrial;
+   size_t u;
+   int i;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_mapParallel() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* An empty table gives empty parts, which are still reduced. */
+   asParts[0].uCount = 0;
+   asParts[0].ulKeySum = 0;
+   asParts[0].uWrongValues = 0;
+   asParts[0].pvValue = oSymTable;
+   apvParts[0] = &asParts[0];
+   sTotal = asParts[0];
+   SymTable_mapParallel(oSymTable, 1, totalBinding, apvParts, addTotal,
+      &sTotal);
+   ASSURE(sTotal.uCount == 0);
+
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, oSymTable);
+      ASSURE(iSuccessful);
+   }
+
+   /* SymTable_map() gives the expected totals. */
+   sExpected = asParts[0];
+   SymTable_map(oSymTable, totalBinding, &sExpected);
+   ASSURE(sExpected.uCount == (size_t)iBindingCount);
+   ASSURE(sExpected.uWrongValues == 0);
+
+   for (uTrial = 0; uTrial < sizeof(auThreads) / sizeof(auThreads[0]);
+        uTrial++)
+   {
+      for (u = 0; u < auThreads[uTrial]; u++)
+      {
+         asParts[u] = asParts[0];
+         asParts[u].uCount = 0;
+         asParts[u].ulKeySum = 0;
+         apvParts[u] = &asParts[u];
+      }
+      sTotal = asParts[0];
+      SymTable_mapParallel(oSymTable, auThreads[uTrial], totalBinding,
+         apvParts, addTotal, &sTotal);
+      ASSURE(sTotal.uCount == sExpected.uCount);
+      ASSURE(sTotal.ulKeySum == sExpected.ulKeySum);
+      ASSURE(sTotal.uWrongValues == 0);
+   }
+
+   /* Without a reduce function, the parts hold the results. */
+   asParts[0].uCount = 0;
+   asParts[1].uCount = 0;
+   SymTable_mapParallel(oSymTable, 2, totalBinding, apvParts, NULL,
+      NULL);
+   ASSURE(asParts[0].uCount + asParts[1].uCount == sExpected.uCount);
+
+   SymTable_free(oSymTable);
+}
+#endif
+
+/*--------------------------------------------------------------------*/
+
+#ifdef HAS_THREADS
+/* The work of one thread of testConcurrency(). */
+
+struct ThreadTest
+{
+   /* The SymTable object that every thread shares */
+   SymTable_T oSymTable;
+   /* The number of this thread */
+   int iThread;
+   /* The number of private keys this thread binds */
+   int iKeyCount;
+   /* The number of shared keys this thread was first to bind */
+   int iSharedWins;
+};
+
+/* The number of threads that testConcurrency() runs */
+enum {THREAD_COUNT = 8};
+
+/* The number of keys that every thread of testConcurrency() tries
+   to bind */
+enum {SHARED_KEY_COUNT = 1000};
+
+/* Run the thread described by pvTest, a struct ThreadTest. The
+   thread checks the semantics of every SymTable function on keys no
+   other thread uses, while racing the other threads to bind shared
+   keys. Return NULL. */
+
+static void *runThreadTest(void *pvTest)
+{
+   enum {MAX_KEY_LENGTH = 32};
+
+   struct ThreadTest *psTest = (struct ThreadTest*)pvTest;
+   SymTable_T oSymTable = psTest->oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   char acSharedKey[MAX_KEY_LENGTH];
+   struct ThreadTest *psNext;
+   void *pvReplaced = &psTest->iKeyCount;
+   void *pvValue;
+   int i;
+
+   for (i = 0; i < psTest->iKeyCount; i++)
+   {
+      sprintf(acKey, "%d.%d", psTest->iThread, i);
+      ASSURE(SymTable_put(oSymTable, acKey, psTest));
+      ASSURE(! SymTable_put(oSymTable, acKey, NULL));
+      ASSURE(SymTable_contains(oSymTable, acKey));
+      ASSURE(SymTable_get(oSymTable, acKey) == psTest);
+      ASSURE(SymTable_replace(oSymTable, acKey, pvReplaced) == psTest);
+
+      sprintf(acSharedKey, "shared.%d", i % SHARED_KEY_COUNT);
+      if (SymTable_put(oSymTable, acSharedKey, psTest))
+         psTest->iSharedWins++;
+      ASSURE(SymTable_get(oSymTable, acSharedKey) != NULL);
+      ASSURE(SymTable_replace(oSymTable, acSharedKey, acSharedKey)
+         != NULL);
+
+      ASSURE(SymTable_getLength(oSymTable) > 0);
+   }
+
+   /* Remove every odd private key while other threads keep
+      binding theirs. */
+   for (i = 0; i < psTest->iKeyCount; i++)
+   {
+      sprintf(acKey, "%d.%d", psTest->iThread, i);
+      if (i % 2 == 1)
+      {
+         ASSURE(SymTable_remove(oSymTable, acKey) == pvReplaced);
+         ASSURE(! SymTable_contains(oSymTable, acKey));
+         ASSURE(SymTable_remove(oSymTable, acKey) == NULL);
+      }
+      else
+         ASSURE(SymTable_get(oSymTable, acKey) == pvReplaced);
+   }
+
+   /* Look up the keys of the next thread, which may be putting,
+      replacing, or removing them meanwhile. */
+   psNext = psTest + 1;
+   if (psTest->iThread == THREAD_COUNT - 1)
+      psNext = psTest - (THREAD_COUNT - 1);
+   for (i = 0; i < psTest->iKeyCount; i++)
+   {
+      sprintf(acKey, "%d.%d", psNext->iThread, i);
+      pvValue = SymTable_get(oSymTable, acKey);
+      ASSURE(pvValue == NULL || pvValue == psNext
+         || pvValue == &psNext->iKeyCount);
+   }
+
+   return NULL;
+}
+
+/* Test a SymTable object that THREAD_COUNT threads use at once,
+   binding iBindingCount private keys among them. Write the CPU time
+   consumed to stdout. */
+
+static void testConcurrency(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   pthread_t aiThreads[THREAD_COUNT];
+   struct ThreadTest asTests[THREAD_COUNT];
+   int iKeyCount = iBindingCount / THREAD_COUNT;
+   int iSharedCount;
+   int iSharedWins = 0;
+   int iBindings = 0;
+   int iStarted;
+   int i;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTable object used by %d threads at once.\n",
+      THREAD_COUNT);
+   printf("No output except CPU time consumed should appear here:\n");
+   fflush(stdout);
+
+   iSharedCount = iKeyCount < SHARED_KEY_COUNT
+      ? iKeyCount : SHARED_KEY_COUNT;
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   iInitialClock = clock();
+   for (iStarted = 0; iStarted < THREAD_COUNT; iStarted++)
+   {
+      asTests[iStarted].oSymTable = oSymTable;
+      asTests[iStarted].iThread = iStarted;
+      asTests[iStarted].iKeyCount = iKeyCount;
+      asTests[iStarted].iSharedWins = 0;
+      if (pthread_create(&aiThreads[iStarted], NULL, runThreadTest,
+            &asTests[iStarted]) != 0)
+         break;
+   }
+   ASSURE(iStarted == THREAD_COUNT);
+   for (i = 0; i < iStarted; i++)
+   {
+      pthread_join(aiThreads[i], NULL);
+      iSharedWins += asTests[i].iSharedWins;
+   }
+   iFinalClock = clock();
+
+   /* Each shared key was bound by exactly one thread, and each
+      thread kept its even private keys. */
+   ASSURE(iSharedWins == iSharedCount);
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)(iSharedCount
+      + iStarted * (iKeyCount - iKeyCount / 2)));
+   SymTable_map(oSymTable, countBinding, &iBindings);
+   ASSURE(iBindings == (int)SymTable_getLength(oSymTable));
+
+   SymTable_free(oSymTable);
+
+   printf("CPU time (%d bindings, %d threads):  %f seconds\n",
+      iBindingCount, THREAD_COUNT,
+      ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC);
+   fflush(stdout);
+}
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* Test a SymTable object whose iBindingCount keys are long
+   identifiers that share most of their characters with other keys, as
+   qualified names in a compiler do. Write the time consumed to
+   stdout. */
+
+static void testSharedPrefixes(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 80};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   int i;
+   int iSuccessful;
+   size_t uLength;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+#ifdef HAS_SORTED_MAP
+   struct Order sOrder;
+#endif
+
+   printf("------------------------------------------------------\n");
+   printf("Testing keys with shared prefixes.\n");
+   printf("No output except CPU time consumed should appear here:\n");
+   fflush(stdout);
+
+   iInitialClock = clock();
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "translation_unit_%d::namespace_%d::identifier_%d",
+         i % 7, i % 101, i);
+      iSuccessful = SymTable_put(oSymTable, acKey, "identifier");
+      ASSURE(iSuccessful);
+   }
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == (size_t)iBindingCount);
+
+   /* Each key is present, and the prefixes that keys share are not. */
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "translation_unit_%d::namespace_%d::identifier_%d",
+         i % 7, i % 101, i);
+      ASSURE(SymTable_get(oSymTable, acKey) != NULL);
+      sprintf(acKey, "translation_unit_%d::namespace_%d::",
+         i % 7, i % 101);
+      ASSURE(! SymTable_contains(oSymTable, acKey));
+   }
+
+   /* Remove the keys of every odd binding. */
+   for (i = 1; i < iBindingCount; i += 2)
+   {
+      sprintf(acKey, "translation_unit_%d::namespace_%d::identifier_%d",
+         i % 7, i % 101, i);
+      ASSURE(SymTable_remove(oSymTable, acKey) != NULL);
+      ASSURE(! SymTable_contains(oSymTable, acKey));
+   }
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == (size_t)(iBindingCount - iBindingCount / 2));
+   for (i = 0; i < iBindingCount; i += 2)
+   {
+      sprintf(acKey, "translation_unit_%d::namespace_%d::identifier_%d",
+         i % 7, i % 101, i);
+      ASSURE(SymTable_contains(oSymTable, acKey));
+   }
+
+#ifdef HAS_SORTED_MAP
+   sOrder.pcPrevious = NULL;
+   sOrder.iCount = 0;
+   sOrder.iOutOfOrder = 0;
+   SymTable_map(oSymTable, checkOrder, &sOrder);
+   ASSURE(sOrder.iCount == iBindingCount - iBindingCount / 2);
+   ASSURE(sOrder.iOutOfOrder == 0);
+#endif
+
+   SymTable_free(oSymTable);
+
+   iFinalClock = clock();
+   printf("CPU time (%d bindings, shared prefixes):  %f seconds\n",
+      iBindingCount,
+      ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC);
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the ability of a SymTable object to be large, that is, to
+   contain iBindingCount bindings. Write the time consumed to stdout. */
+
+static void testLargeTable(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   SymTable_T oSymTableSmall;
+   char acKey[MAX_KEY_LENGTH];
+   char *pcValue;
+   int i;
+   int iSmall;
+   int iLarge;
+   int iSuccessful;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+   size_t uLength = 0;
+   size_t uLength2;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a potentially large SymTable object.\n");
+   printf("No output except CPU time consumed should appear here:\n");
+   fflush(stdout);
+
+   /* Note the current time. */
+   iInitialClock = clock();
+
+   /* Create oSymTableSmall, and put a couple of bindings into it. */
+   oSymTableSmall = SymTable_new();
+   ASSURE(oSymTableSmall != NULL);
+   iSuccessful = SymTable_put(oSymTableSmall, "xxx", "xxx");
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTableSmall, "yyy", "yyy");
+   ASSURE(iSuccessful);
+
+   /* Create oSymTable, the primary SymTable object. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* Put iBindingCount new bindings into oSymTable.  Each binding's
+      key and value contain the same characters. */
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      pcValue = (char*)malloc(sizeof(char) * (strlen(acKey) + 1));
+      ASSURE(pcValue != NULL);
+      strcpy(pcValue, acKey);
+      iSuccessful = SymTable_put(oSymTable, acKey, pcValue);
+      ASSURE(iSuccessful);
+      uLength = SymTable_getLength(oSymTable);
+      ASSURE(uLength == (size_t)(i+1));
+   }
+
+   /* Get each binding's value, and make sure that it contains
+      the same characters as its key. */
+   iSmall = 0;
+   iLarge = iBindingCount - 1;
+   while (iSmall < iLarge)
+   {
+      /* Get the smallest of the remaining bindings. */
+      sprintf(acKey, "%d", iSmall);
+      pcValue = (char*)SymTable_get(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+      iSmall++;
+      /* Get the largest of the remaining bindings. */
+      sprintf(acKey, "%d", iLarge);
+      pcValue = (char*)SymTable_get(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+      iLarge--;
+   }
+   /* Get the middle binding -- if there is one. */
+   if (iSmall == iLarge)
+   {
+      sprintf(acKey, "%d", iSmall);
+      pcValue = (char*)SymTable_get(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+   }
+
+   /* Remove each binding. Also free each binding's value. */
+   iSmall = 0;
+   iLarge = iBindingCount - 1;
+   while (iSmall < iLarge)
+   {
+      /* Remove the smallest of the remaining bindings. */
+      sprintf(acKey, "%d", iSmall);
+      pcValue = (char*)SymTable_remove(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+      free(pcValue);
+      uLength--;
+      uLength2 = SymTable_getLength(oSymTable);
+      ASSURE(uLength2 == uLength);
+      iSmall++;
+      /* Remove the largest of the remaining bindings. */
+      sprintf(acKey, "%d", iLarge);
+      pcValue = (char*)SymTable_remove(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+      free(pcValue);
+      uLength--;
+      uLength2 = SymTable_getLength(oSymTable);
+      ASSURE(uLength2 == uLength);
+      iLarge--;
+   }
+   /* Remove the middle binding -- if there is one. */
+   if (iSmall == iLarge)
+   {
+      sprintf(acKey, "%d", iSmall);
+      pcValue = (char*)SymTable_remove(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+      free(pcValue);
+      uLength--;
+      uLength2 = SymTable_getLength(oSymTable);
+      ASSURE(uLength2 == uLength);  
+   }
+
+   /* Make sure oSymTableSmall hasn't been corrupted by expansion
+      of oSymTable. */
+   pcValue = (char*)SymTable_get(oSymTableSmall, "xxx");
+   ASSURE((pcValue != NULL) && (strcmp(pcValue, "xxx") == 0));
+   pcValue = (char*)SymTable_get(oSymTableSmall, "yyy");
+   ASSURE((pcValue != NULL) && (strcmp(pcValue, "yyy") == 0));
+
+   /* Free both SymTable objects. */
+   SymTable_free(oSymTable);
+   SymTable_free(oSymTableSmall);
+
+   /* Note the current time, and print the time consumed to stdout. */
+   iFinalClock = clock();
+   printf("CPU time (%d bindings):  %f seconds\n", iBindingCount,
+      ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC);
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable ADT.  Write the output of the tests to stdout.
+   As always, argc is the command-line argument count, argv contains
+   the command-line arguments, and argv[0] is the name of the
+   executable binary file. argv[1] is the number of bindings to put
+   into a potentially large SymTable object.  Exit with EXIT_FAILURE
+   if argv[1] is missing or not numeric.  Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   {
+      fprintf(stderr, "bindingcount must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount cannot be negative\n");
+      exit(EXIT_FAILURE);
+   }
+   
+#ifndef S_SPLINT_S
+   setCpuTimeLimit();
+#endif
+
+   testBasics();
+   testKeyComparison();
+   testKeyOwnership();
    testRemove();
    testMap();
    testEmptyTable();
@@ -959,7 +2879,51 @@ int main(int argc, char *argv[])
    testNullValue();
    testLongKey();
    testTableOfTables();
+   testSmallTables();
    testCollisions();
+#ifdef HAS_NEW_WITH_HASH
+   testHashFunctions();
+#endif
+#ifdef HAS_HASHED_KEYS
+   testHashedKeys();
+#endif
+#ifdef HAS_KEY_POOL
+   testKeyPool();
+#endif
+#ifdef HAS_SCOPES
+   testScopes();
+#endif
+#ifdef HAS_SNAPSHOT
+   testSnapshots();
+#endif
+#ifdef HAS_CLONE
+   testClone();
+#endif
+#ifdef HAS_SAVE
+   testSaveAndLoad();
+#endif
+#ifdef HAS_FREEZE
+   testFreeze();
+#endif
+#ifdef COUNT_ALLOCATIONS
+   testAllocations();
+#endif
+#ifdef HAS_ITERATOR
+   testIterator();
+#endif
+#ifdef HAS_ORDERED_MAP
+   testOrderedMap();
+#endif
+#ifdef HAS_GET_MANY
+   testGetMany(iBindingCount);
+#endif
+#ifdef HAS_MAP_PARALLEL
+   testMapParallel(iBindingCount);
+#endif
+#ifdef HAS_THREADS
+   testConcurrency(iBindingCount);
+#endif
+   testSharedPrefixes(iBindingCount);
    testLargeTable(iBindingCount);
 
    printf("------------------------------------------------------\n");